@@ -0,0 +1,296 @@
+//
+// Software raymarcher, mirrors raymarch.frag
+//
+
+#include "CPURaymarcher.h"
+#include <algorithm>
+#include "utilities/ThreadPool.h"
+
+using namespace glm;
+
+// -- Simple Lambertian Diffuse lighting + Selection Highlight (applyLighting) --
+static vec3 applyLighting(const CPURenderSettings& settings, const vec3& baseColor, const vec3& normal, bool isSelected, bool isHovered) {
+    vec3 litColorWithHighlight = baseColor;
+    if (settings.lighting) {
+        vec3 lightDir = normalize(vec3(0.8f, -1.0f, 0.5f));
+        float diffuse = max(0.0f, dot(normal, lightDir));
+        vec3 ambient = vec3(0.1f) * baseColor;
+        litColorWithHighlight = ambient + baseColor * diffuse;
+    }
+    if (settings.selectionHighlight) {
+        if (isSelected) {
+            litColorWithHighlight += vec3(0.2f, 0.2f, 0.0f);
+        } else if (isHovered) {
+            litColorWithHighlight += vec3(0.08f, 0.08f, 0.08f);
+        }
+    }
+    return clamp(litColorWithHighlight, 0.0f, 1.0f);
+}
+
+vec3 CPURaymarcher::getRayDir(const CPURenderSettings& settings, float pixelX, float pixelY) const {
+    // fragCoordScreen at the pixel centre, -1 to 1
+    vec2 uv = vec2((pixelX + 0.5f) / static_cast<float>(settings.width),
+                   (pixelY + 0.5f) / static_cast<float>(settings.height)) * 2.0f - 1.0f;
+
+    float aspectRatio = static_cast<float>(settings.width) / static_cast<float>(settings.height);
+    float tanHalfFov = tan(radians(settings.fov * 0.5f));
+
+    vec3 viewDir = vec3(uv.x * aspectRatio * tanHalfFov, uv.y * tanHalfFov, -1.0f);
+    return normalize(settings.cameraBasis * viewDir);
+}
+
+vec2 CPURaymarcher::intersectSceneBounds(const CPURenderSettings& settings, const vec3& origin, const vec3& direction) {
+    vec3 invDir;
+    for (int c = 0; c < 3; ++c) invDir[c] = 1.0f / (direction[c] == 0.0f ? 1e-8f : direction[c]);
+    vec3 t0 = (settings.sceneBoundsMin - origin) * invDir;
+    vec3 t1 = (settings.sceneBoundsMax - origin) * invDir;
+    vec3 tNear = min(t0, t1);
+    vec3 tFar = max(t0, t1);
+    float entry = max(max(tNear.x, tNear.y), max(tNear.z, 0.0f));
+    float exit = min(min(tFar.x, tFar.y), tFar.z);
+    return vec2(entry, exit);
+}
+
+void CPURaymarcher::marchRays(const vec3* origins, const vec3* directions, int count,
+                              const CPURenderSettings& settings, CPURayResult* results, bool enhanced) const {
+    if (count <= 0) return;
+    const int selectedIndex = settings.selectedIndex;
+    const int hoveredIndex = settings.hoveredIndex;
+    const vec3& clearColor = settings.clearColor;
+
+    // Over-relaxed sphere tracing state per ray, same as rayMarch in the shader
+    const float lipschitz = m_evaluator.getLipschitzBound();
+    std::vector<float> omega(count, enhanced ? max(settings.relaxation, 1.0f) : 1.0f);
+    std::vector<float> prevRadius(count, 0.0f);
+    std::vector<float> stepDist(count, 0.0f);
+
+    // Cone hit test, same as the shader
+    const int maxSteps = enhanced ? min(settings.maxSteps, MAX_STEPS) : MAX_STEPS;
+    const float pixelAngle = 2.0f * tan(radians(settings.fov * 0.5f)) / static_cast<float>(settings.height);
+    const float coneSlope = enhanced ? pixelAngle * settings.coneScale : 0.0f;
+
+    // Start at the scene bounds entry, stop at the exit (rays that miss them take no steps)
+    std::vector<float> totalDist(count, 0.0f);
+    std::vector<float> maxDist(count, sdfkernels::MAX_DIST);
+    std::vector<int> active;
+    active.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        if (enhanced) {
+            vec2 range = intersectSceneBounds(settings, origins[i], directions[i]);
+            if (range.x > range.y) {
+                results[i] = CPURayResult{clearColor, 0, false, sdfkernels::MAX_DIST, -1, false};
+                continue;
+            }
+            totalDist[i] = range.x;
+            maxDist[i] = min(sdfkernels::MAX_DIST, range.y);
+        }
+        active.push_back(i);
+    }
+
+    std::vector<vec3> points(count);
+    std::vector<float> dist(count);
+    std::vector<int> index(count);
+    std::vector<vec3> color(count);
+    std::vector<int> hits;
+
+    // -- rayMarch, every active ray advances one step per batch --
+    for (int step = 0; step < maxSteps && !active.empty(); ++step) {
+        const int n = static_cast<int>(active.size());
+        for (int j = 0; j < n; ++j) {
+            int ray = active[j];
+            points[j] = origins[ray] + directions[ray] * totalDist[ray];
+        }
+        m_evaluator.evaluateBatch(points.data(), n, dist.data(), index.data(), color.data());
+
+        int stillActive = 0;
+        for (int j = 0; j < n; ++j) {
+            int ray = active[j];
+            CPURayResult& result = results[ray];
+            float radius = enhanced ? dist[j] / lipschitz : dist[j] * 0.90f;
+
+            if (omega[ray] > 1.0f && radius + prevRadius[ray] < stepDist[ray]) {
+                // Overshoot (or stepped inside): back to the end of the unrelaxed step
+                totalDist[ray] += prevRadius[ray] - stepDist[ray];
+                stepDist[ray] = prevRadius[ray];
+                omega[ray] = 1.0f;
+                active[stillActive++] = ray;
+                continue;
+            }
+
+            if (dist[j] < max(HIT_THRESHOLD, totalDist[ray] * coneSlope)) {
+                result.color = color[j]; // Lit after the normals are known
+                result.steps = step + 1;
+                result.hit = true;
+                result.finalDist = totalDist[ray];
+                result.hitObjectIndex = index[j];
+                result.hitSelected = (index[j] != -1 && index[j] == selectedIndex);
+                result.hitHovered = (index[j] != -1 && index[j] == hoveredIndex);
+                hits.push_back(ray);
+                continue;
+            }
+
+            if (totalDist[ray] > maxDist[ray]) {
+                result = CPURayResult{clearColor, step + 1, false, totalDist[ray], -1, false};
+                continue;
+            }
+
+            prevRadius[ray] = radius;
+            stepDist[ray] = max(HIT_THRESHOLD * 0.1f, radius * omega[ray]);
+            totalDist[ray] += stepDist[ray];
+            omega[ray] = enhanced ? max(settings.relaxation, 1.0f) : 1.0f;
+            active[stillActive++] = ray;
+        }
+        active.resize(stillActive);
+    }
+
+    // Missed (step budget exhausted)
+    for (int ray : active) {
+        results[ray] = CPURayResult{clearColor, maxSteps, false, totalDist[ray], -1, false};
+    }
+
+    if (hits.empty()) return;
+
+    // -- calcNormal, analytic gradient: one scalar evaluation per hit --
+    std::vector<int> fallback;
+    if (settings.normalMethod == 0) {
+        for (int ray : hits) {
+            CPURayResult& result = results[ray];
+            vec3 gradient;
+            m_evaluator.evaluateWithGradient(origins[ray] + directions[ray] * result.finalDist, gradient);
+            // Zero gradient falls back to the differences, like the shader
+            if (dot(gradient, gradient) > 1e-12f) {
+                result.normal = normalize(gradient);
+                result.color = applyLighting(settings, result.color, result.normal, result.hitSelected, result.hitHovered);
+            } else {
+                fallback.push_back(ray);
+            }
+        }
+        hits.swap(fallback);
+        if (hits.empty()) return;
+    }
+
+    // -- calcNormal, six taps per hit evaluated as one batch --
+    const int hitCount = static_cast<int>(hits.size());
+    std::vector<vec3> taps(hitCount * 6);
+    std::vector<float> tapDist(hitCount * 6);
+    for (int j = 0; j < hitCount; ++j) {
+        const CPURayResult& result = results[hits[j]];
+        vec3 p = origins[hits[j]] + directions[hits[j]] * result.finalDist;
+        float epsilon = max(result.finalDist * 0.0005f, HIT_THRESHOLD * 0.1f);
+        vec3* tap = &taps[j * 6];
+        tap[0] = p + vec3(epsilon, 0.0f, 0.0f); tap[1] = p - vec3(epsilon, 0.0f, 0.0f);
+        tap[2] = p + vec3(0.0f, epsilon, 0.0f); tap[3] = p - vec3(0.0f, epsilon, 0.0f);
+        tap[4] = p + vec3(0.0f, 0.0f, epsilon); tap[5] = p - vec3(0.0f, 0.0f, epsilon);
+    }
+    m_evaluator.evaluateBatch(taps.data(), hitCount * 6, tapDist.data());
+
+    for (int j = 0; j < hitCount; ++j) {
+        CPURayResult& result = results[hits[j]];
+        const float* d = &tapDist[j * 6];
+        result.normal = normalize(vec3(d[0] - d[1], d[2] - d[3], d[4] - d[5]));
+        result.color = applyLighting(settings, result.color, result.normal, result.hitSelected, result.hitHovered);
+    }
+}
+
+int CPURaymarcher::pickObject(const CPURenderSettings& settings, int cursorX, int cursorY) const {
+    // Window rows go down, gl_FragCoord rows go up
+    const int pixelY = settings.height - 1 - cursorY;
+    if (cursorX < 0 || cursorX >= settings.width || pixelY < 0 || pixelY >= settings.height) return -1;
+
+    vec3 origin = settings.cameraPos;
+    vec3 direction = getRayDir(settings, static_cast<float>(cursorX), static_cast<float>(pixelY));
+    CPURayResult result;
+    marchRays(&origin, &direction, 1, settings, &result);
+    return result.hitObjectIndex;
+}
+
+vec3 CPURaymarcher::shadeDebug(const CPURayResult& result, int debugMode, const vec3& clearColor) const {
+    switch (debugMode) {
+        case 1: // Show Steps (render() draws the comparison divider)
+            return vec3(static_cast<float>(result.steps) / static_cast<float>(MAX_STEPS));
+        case 2: // Show Hit/Miss
+            return result.hit ? vec3(1.0f) : vec3(0.0f);
+        case 3: // Show Normals
+            return result.hit ? result.normal * 0.5f + 0.5f : vec3(0.0f);
+        case 4: // Object ID
+            if (result.hit) {
+                float hue = fract(static_cast<float>(result.hitObjectIndex) * 0.61803398875f);
+                vec3 hsv = vec3(hue, 0.8f, 0.8f);
+                vec4 K = vec4(1.0f, 2.0f / 3.0f, 1.0f / 3.0f, 1.0f);
+                vec3 p = abs(fract(vec3(hsv.x) + vec3(K.x, K.y, K.z)) * 6.0f - vec3(K.w));
+                return hsv.z * mix(vec3(K.x), clamp(p - vec3(K.x), 0.0f, 1.0f), hsv.y);
+            }
+            return clearColor;
+        default: // Case 0 : normal rendering
+            return result.color;
+    }
+}
+
+void CPURaymarcher::render(const CPURenderSettings& settings, ThreadPool& pool, CPURenderImage& image) const {
+    image.width = settings.width;
+    image.height = settings.height;
+    image.color.assign(static_cast<size_t>(settings.width) * settings.height, settings.clearColor);
+    image.objectIds.assign(static_cast<size_t>(settings.width) * settings.height, -1);
+    if (settings.width <= 0 || settings.height <= 0) return;
+
+    const int tileSize = max(1, settings.tileSize);
+    const int tilesX = (settings.width + tileSize - 1) / tileSize;
+    const int tilesY = (settings.height + tileSize - 1) / tileSize;
+
+    pool.parallelFor(tilesX * tilesY, [&](int tile) {
+        const int x0 = (tile % tilesX) * tileSize;
+        const int y0 = (tile / tilesX) * tileSize;
+        const int x1 = min(x0 + tileSize, settings.width);
+        const int y1 = min(y0 + tileSize, settings.height);
+        const int pixelCount = (x1 - x0) * (y1 - y0);
+
+        std::vector<vec3> origins(pixelCount, settings.cameraPos);
+        std::vector<vec3> directions(pixelCount);
+        for (int y = y0, i = 0; y < y1; ++y) {
+            for (int x = x0; x < x1; ++x, ++i) {
+                directions[i] = getRayDir(settings, static_cast<float>(x), static_cast<float>(y));
+            }
+        }
+
+        std::vector<CPURayResult> results(pixelCount);
+        const bool compare = (settings.debugMode == 1 && settings.stepsCompare);
+        const int splitX = settings.width / 2; // gl_FragCoord.x < 0.5 * width
+        const int leftCount = (compare && x0 < splitX) ? (min(x1, splitX) - x0) : 0;
+        if (leftCount == 0) {
+            marchRays(origins.data(), directions.data(), pixelCount, settings, results.data());
+        } else {
+            // The comparison marches the pixels left of the split the old way, one packet per side
+            const int rowWidth = x1 - x0;
+            const int rightCount = rowWidth - leftCount;
+            std::vector<vec3> sideDirs;
+            std::vector<CPURayResult> sideResults;
+            for (int side = 0; side < 2; ++side) {
+                const int first = (side == 0) ? 0 : leftCount;
+                const int width = (side == 0) ? leftCount : rightCount;
+                if (width == 0) continue;
+                sideDirs.clear();
+                for (int row = 0; row < y1 - y0; ++row) {
+                    sideDirs.insert(sideDirs.end(), directions.begin() + row * rowWidth + first,
+                                    directions.begin() + row * rowWidth + first + width);
+                }
+                sideResults.assign(sideDirs.size(), CPURayResult{});
+                marchRays(origins.data(), sideDirs.data(), static_cast<int>(sideDirs.size()), settings, sideResults.data(), side == 1);
+                for (int row = 0; row < y1 - y0; ++row) {
+                    std::copy(sideResults.begin() + row * width, sideResults.begin() + (row + 1) * width,
+                              results.begin() + row * rowWidth + first);
+                }
+            }
+        }
+
+        for (int y = y0, i = 0; y < y1; ++y) {
+            for (int x = x0; x < x1; ++x, ++i) {
+                size_t pixel = static_cast<size_t>(y) * settings.width + x;
+                image.color[pixel] = shadeDebug(results[i], settings.debugMode, settings.clearColor);
+                if (compare && abs(static_cast<float>(x) + 0.5f - 0.5f * static_cast<float>(settings.width)) < 1.0f) {
+                    image.color[pixel] = vec3(1.0f, 0.0f, 0.0f); // Divider
+                }
+                image.objectIds[pixel] = results[i].hitObjectIndex;
+            }
+        }
+    });
+}
@@ -0,0 +1,87 @@
+//
+// Software version of rayMarch / calcNormal / applyLighting from raymarch.frag.
+// Renders the image in tiles spread over a ThreadPool, no GL context required.
+//
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+#include "Basic/SDFEvaluator.h"
+
+class ThreadPool;
+
+// Everything the fragment shader reads from uniforms
+struct CPURenderSettings {
+    int width = 1920;
+    int height = 1080;
+    glm::vec3 cameraPos = glm::vec3(0.0f);
+    glm::mat3 cameraBasis = glm::mat3(1.0f);
+    float fov = 45.0f;
+    glm::vec3 clearColor = glm::vec3(0.0f);
+    int debugMode = 0;       // Same values as u_debugMode
+    int selectedIndex = -1;  // Same as u_selectedObjectID
+    int hoveredIndex = -1;   // Same as u_hoveredObjectID
+    int normalMethod = 0;    // Same values as u_normalMethod (0 analytic, 1 finite difference)
+    float relaxation = 1.5f; // Same as u_relaxation
+    bool stepsCompare = false; // Same as u_stepsCompare
+    int maxSteps = 200;      // Same as u_maxSteps (QualityPreset::BALANCED)
+    float coneScale = 1.0f;  // Same as u_coneScale
+    glm::vec3 sceneBoundsMin = glm::vec3(-1e6f); // Same as u_sceneBoundsMin / Max, the default clips nothing
+    glm::vec3 sceneBoundsMax = glm::vec3(1e6f);
+    bool lighting = true;    // Same as u_lighting
+    bool selectionHighlight = true; // Same as u_selectionHighlight
+    int tileSize = 32;       // Pixels per tile side
+};
+
+// Pixels are stored bottom row first, the same order glReadPixels returns
+struct CPURenderImage {
+    int width = 0;
+    int height = 0;
+    std::vector<glm::vec3> color;  // out_color.rgb
+    std::vector<int> objectIds;    // out_ObjectID
+};
+
+// Same fields as RayMarchResult in raymarch.frag, plus the normal used for shading.
+// On a miss, steps counts the scene evaluations (0 when the ray misses the scene bounds)
+struct CPURayResult {
+    glm::vec3 color = glm::vec3(0.0f);
+    int steps = 0;
+    bool hit = false;
+    float finalDist = 0.0f;
+    int hitObjectIndex = -1;
+    bool hitSelected = false;
+    bool hitHovered = false;
+    glm::vec3 normal = glm::vec3(0.0f);
+};
+
+class CPURaymarcher {
+public:
+    // Must match raymarch.frag
+    static constexpr int MAX_STEPS = 500;   // Hard cap, settings.maxSteps picks the budget
+    static constexpr float HIT_THRESHOLD = 0.001f;
+
+    explicit CPURaymarcher(const SDFEvaluator& evaluator) : m_evaluator(evaluator) {}
+
+    // Ray through a pixel centre, like getRayDir with the vertex shader's interpolated position
+    glm::vec3 getRayDir(const CPURenderSettings& settings, float pixelX, float pixelY) const;
+
+    // Marches count rays as one packet, so every step is a single batched evaluator call.
+    // Reads the highlight indices, clear color, normal method and relaxation from settings.
+    // enhanced = false is the original march (left half of the Steps comparison)
+    void marchRays(const glm::vec3* origins, const glm::vec3* directions, int count,
+                   const CPURenderSettings& settings, CPURayResult* results, bool enhanced = true) const;
+
+    // Object index the shader writes to out_ObjectID under a window-space cursor (top-left origin), -1 for background.
+    // Marches the single ray through that pixel's centre, so no render target or GPU readback is needed
+    int pickObject(const CPURenderSettings& settings, int cursorX, int cursorY) const;
+
+    // Entry and exit distance through the scene bounds (intersectSceneBounds in the shader), x > y on a miss
+    static glm::vec2 intersectSceneBounds(const CPURenderSettings& settings, const glm::vec3& origin, const glm::vec3& direction);
+
+    // Final pixel color for a ray, applies the u_debugMode switch from main() in the shader
+    glm::vec3 shadeDebug(const CPURayResult& result, int debugMode, const glm::vec3& clearColor) const;
+
+    void render(const CPURenderSettings& settings, ThreadPool& pool, CPURenderImage& image) const;
+
+private:
+    const SDFEvaluator& m_evaluator;
+};
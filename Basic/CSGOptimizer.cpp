@@ -0,0 +1,168 @@
+//
+// CSG tree optimizer
+//
+
+#include "CSGOptimizer.h"
+#include <limits>
+#include <unordered_map>
+
+using namespace glm;
+
+namespace {
+    // The distance of a subtree is never below the distance to this sphere (the same premise as the
+    // bounding sphere early out in blendObject), as long as it is exact. An underestimating distance (the
+    // ellipsoid) can dip below it, the sphere then only says where the surface is
+    struct Bound {
+        vec3 center = vec3(0.0f);
+        float radius = 0.0f;
+        bool exact = true;
+    };
+
+    struct Folded {
+        int node = -1;      // In the optimized tree, -1 = empty (the subtree has no surface)
+        Bound bound;
+        int stackNeed = 0;  // Stack entries the postfix program of the subtree uses
+    };
+
+    // Smallest distance between the surfaces of the two spheres, negative if they overlap
+    float getGap(const Bound& a, const Bound& b) {
+        return distance(a.center, b.center) - a.radius - b.radius;
+    }
+
+    // Lower bound of a + b everywhere, which getGap only is when both distances are exact
+    float getDistanceGap(const Bound& a, const Bound& b) {
+        return (a.exact && b.exact) ? getGap(a, b) : -std::numeric_limits<float>::infinity();
+    }
+
+    Bound enclose(const Bound& a, const Bound& b) {
+        const float centerDistance = distance(a.center, b.center);
+        Bound result;
+        if (centerDistance + b.radius <= a.radius) result = a;
+        else if (centerDistance + a.radius <= b.radius) result = b;
+        else {
+            result.radius = 0.5f * (centerDistance + a.radius + b.radius);
+            result.center = a.center + (b.center - a.center) * ((result.radius - a.radius) / centerDistance);
+        }
+        result.exact = a.exact && b.exact;
+        return result;
+    }
+}
+
+bool CSGOptimizer::optimize(const CSGTree& tree, const std::vector<SDFObject>& objects, const std::vector<SDFObjectGPUData>& gpuData,
+                            float sceneSmoothness, CSGTree& outTree, Stats* outStats) {
+    outTree.clear();
+    Stats stats;
+    const std::vector<CSGTree::Node>& nodes = tree.getNodes();
+    if (tree.getRoot() < 0 || objects.size() != gpuData.size()) return false;
+
+    std::unordered_map<int, int> indexOfId;
+    for (size_t i = 0; i < objects.size(); ++i) indexOfId[objects[i].id] = static_cast<int>(i);
+
+    // Post-order like CSGTree::compile, every node is folded after both of its operands
+    std::vector<Folded> folded(nodes.size());
+    std::vector<std::pair<int, bool>> pending;
+    pending.push_back({tree.getRoot(), false});
+    while (!pending.empty()) {
+        auto [nodeIndex, childrenDone] = pending.back();
+        pending.pop_back();
+        const CSGTree::Node& node = nodes[nodeIndex];
+        Folded& result = folded[nodeIndex];
+
+        if (node.isLeaf()) {
+            auto found = indexOfId.find(node.objectId);
+            if (found == indexOfId.end()) {
+                outTree.clear();
+                return false;
+            }
+            const SDFObjectGPUData& data = gpuData[found->second];
+            result.node = outTree.addLeaf(node.objectId);
+            result.bound.center = data.position;
+            result.bound.radius = getBoundingRadius(data);
+            const SDFPrimitive* primitive = SDFPrimitives::find(getObjectType(data));
+            result.bound.exact = primitive && primitive->exact;
+            result.stackNeed = 1;
+            continue;
+        }
+        if (!childrenDone) {
+            pending.push_back({nodeIndex, true});
+            pending.push_back({node.right, false});
+            pending.push_back({node.left, false});
+            continue;
+        }
+
+        const Folded& a = folded[node.left];
+        const Folded& b = folded[node.right];
+        float k = (node.smoothness < 0.0f) ? sceneSmoothness : node.smoothness;
+
+        // Operands that leave the other one as it is. Exact bounds give a + b >= gap everywhere, so:
+        // - union: smin only differs from min where |a - b| < k, and only by up to k / 4. On the surface of either
+        //   operand that needs the other within 5k / 4, so a gap of 1.5k keeps the surface and colors of min
+        // - subtraction: max(a, -b) is a wherever a + b >= k (smooth) or >= 0 (sharp)
+        // - intersection: max(a, b) > 0 everywhere once the spheres are apart, smooth or not. This only needs the
+        //   sign, which every distance gets right outside its sphere, so it goes by the spheres alone
+        const bool bothPresent = a.node >= 0 && b.node >= 0;
+        const float gap = bothPresent ? getDistanceGap(a.bound, b.bound) : 0.0f;
+        if (node.operation == CSGOperation::UNION) {
+            if (!bothPresent) {
+                result = (a.node >= 0) ? a : b;
+                ++stats.prunedJoins;
+                continue;
+            }
+            if (k > 0.0f && gap >= 1.5f * k) {
+                k = 0.0f;
+                ++stats.demotedBlends;
+            }
+        } else if (node.operation == CSGOperation::SUBTRACT) {
+            if (a.node < 0 || b.node < 0 || gap >= k) {
+                result = a;
+                ++stats.prunedJoins;
+                continue;
+            }
+        } else if (!bothPresent || getGap(a.bound, b.bound) > 0.0f) {
+            result = Folded{};
+            ++stats.prunedJoins;
+            continue;
+        }
+
+        // Deeper operand first: the other one then only needs the entries left above it
+        const Folded* first = &a;
+        const Folded* second = &b;
+        if (node.operation != CSGOperation::SUBTRACT && b.stackNeed > a.stackNeed) {
+            std::swap(first, second);
+            ++stats.swappedOperands;
+        }
+        result.node = outTree.addOperation(node.operation, k, first->node, second->node);
+        result.stackNeed = max(first->stackNeed, second->stackNeed + 1);
+        if (node.operation == CSGOperation::UNION) {
+            result.bound = enclose(a.bound, b.bound);
+            result.bound.radius += 0.25f * k; // smin never goes more than k / 4 below min
+        } else if (node.operation == CSGOperation::SUBTRACT) {
+            result.bound = a.bound;
+        } else {
+            // max(a, b) is above both operands, so either bound holds. Prefer an exact one
+            const bool pickA = (a.bound.exact != b.bound.exact) ? a.bound.exact : (a.bound.radius <= b.bound.radius);
+            result.bound = pickA ? a.bound : b.bound;
+        }
+    }
+
+    const int root = folded[tree.getRoot()].node;
+    if (root < 0) {
+        outTree.clear();
+        return false;
+    }
+    outTree.setRoot(root);
+    if (outStats) *outStats = stats;
+    return true;
+}
+
+bool CSGOptimizer::compile(const CSGTree& tree, const std::vector<SDFObject>& objects, const std::vector<SDFObjectGPUData>& gpuData,
+                           float sceneSmoothness, std::vector<CSGInstruction>& outProgram, Stats* outStats) {
+    if (outStats) *outStats = Stats{};
+    if (tree.isPlainUnion(objects)) return tree.compile(objects, sceneSmoothness, outProgram);
+
+    CSGTree optimized;
+    if (!optimize(tree, objects, gpuData, sceneSmoothness, optimized, outStats)) {
+        return tree.compile(objects, sceneSmoothness, outProgram);
+    }
+    return optimized.compile(objects, sceneSmoothness, outProgram);
+}
@@ -0,0 +1,30 @@
+//
+// Simplifies a copy of the scene CSG tree before it is compiled, using the objects' bounding spheres:
+// smooth unions whose operands can never blend on the surface become a plain min, subtractions of shapes out
+// of reach and intersections that are always empty are dropped, and the operands of commutative joins are
+// ordered so the deeper side runs first (fewer stack entries). The surface and its colors are unchanged.
+//
+#pragma once
+#include <vector>
+#include "Basic/CSGTree.h"
+#include "Basic/SDFObject.h"
+
+class CSGOptimizer {
+public:
+    struct Stats {
+        int demotedBlends = 0;      // Smooth unions turned into min
+        int prunedJoins = 0;        // Joins replaced by one of their operands (or by nothing)
+        int swappedOperands = 0;    // Commutative joins whose operands were swapped for stack depth
+    };
+
+    // Simplified copy of 'tree' in 'outTree', every k resolved against sceneSmoothness. gpuData is the object list
+    // in GPU form (same order as objects). Returns false if the tree references a missing object or the whole
+    // scene would be empty, outTree is then left cleared
+    static bool optimize(const CSGTree& tree, const std::vector<SDFObject>& objects, const std::vector<SDFObjectGPUData>& gpuData,
+                         float sceneSmoothness, CSGTree& outTree, Stats* outStats = nullptr);
+
+    // CSGTree::compile on the optimized tree. Plain union scenes still compile to an empty program, and a tree
+    // the optimizer can not handle is compiled as it is
+    static bool compile(const CSGTree& tree, const std::vector<SDFObject>& objects, const std::vector<SDFObjectGPUData>& gpuData,
+                        float sceneSmoothness, std::vector<CSGInstruction>& outProgram, Stats* outStats = nullptr);
+};
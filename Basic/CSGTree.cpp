@@ -0,0 +1,196 @@
+//
+// Scene CSG tree and its postfix compiler
+//
+
+#include "CSGTree.h"
+#include <algorithm>
+#include <iostream>
+#include <unordered_map>
+#include <unordered_set>
+
+int CSGTree::addLeaf(int objectId) {
+    Node node;
+    node.objectId = objectId;
+    m_nodes.push_back(node);
+    markChanged();
+    return static_cast<int>(m_nodes.size()) - 1;
+}
+
+int CSGTree::addOperation(CSGOperation operation, float smoothness, int left, int right) {
+    Node node;
+    node.operation = operation;
+    node.smoothness = smoothness;
+    node.left = left;
+    node.right = right;
+    m_nodes.push_back(node);
+    markChanged();
+    return static_cast<int>(m_nodes.size()) - 1;
+}
+
+void CSGTree::clear() {
+    m_nodes.clear();
+    m_root = -1;
+    markChanged();
+}
+
+int CSGTree::findParent(int node) const {
+    for (size_t i = 0; i < m_nodes.size(); ++i) {
+        if (!m_nodes[i].isLeaf() && (m_nodes[i].left == node || m_nodes[i].right == node)) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+CSGTree::Node* CSGTree::findJoinOf(int objectId) {
+    for (size_t i = 0; i < m_nodes.size(); ++i) {
+        if (m_nodes[i].objectId != objectId) continue;
+        int parent = findParent(static_cast<int>(i));
+        if (parent >= 0 && m_nodes[parent].right == static_cast<int>(i)) return &m_nodes[parent];
+        return nullptr;
+    }
+    return nullptr;
+}
+
+// Drops the nodes the root can no longer reach, keeping the order of the rest
+void CSGTree::compact() {
+    std::vector<int> remap(m_nodes.size(), -1);
+    std::vector<int> pending;
+    if (m_root >= 0) pending.push_back(m_root);
+    while (!pending.empty()) {
+        int node = pending.back();
+        pending.pop_back();
+        remap[node] = 0;
+        if (!m_nodes[node].isLeaf()) {
+            pending.push_back(m_nodes[node].left);
+            pending.push_back(m_nodes[node].right);
+        }
+    }
+
+    std::vector<Node> kept;
+    for (size_t i = 0; i < m_nodes.size(); ++i) {
+        if (remap[i] < 0) continue;
+        remap[i] = static_cast<int>(kept.size());
+        kept.push_back(m_nodes[i]);
+    }
+    for (Node& node : kept) {
+        if (node.isLeaf()) continue;
+        node.left = remap[node.left];
+        node.right = remap[node.right];
+    }
+    m_root = (m_root >= 0) ? remap[m_root] : -1;
+    m_nodes.swap(kept);
+}
+
+bool CSGTree::syncObjects(const std::vector<SDFObject>& objects) {
+    std::unordered_set<int> liveIds;
+    for (const SDFObject& object : objects) liveIds.insert(object.id);
+
+    // 1. Leaves of deleted objects: the parent collapses into the sibling
+    std::unordered_set<int> leafIds;
+    std::vector<int> deadLeaves;
+    for (size_t i = 0; i < m_nodes.size(); ++i) {
+        if (!m_nodes[i].isLeaf()) continue;
+        if (liveIds.count(m_nodes[i].objectId)) {
+            leafIds.insert(m_nodes[i].objectId);
+        } else {
+            deadLeaves.push_back(static_cast<int>(i));
+        }
+    }
+    for (int leaf : deadLeaves) {
+        const int parent = findParent(leaf);
+        if (parent < 0) {
+            if (m_root == leaf) m_root = -1;
+            continue;
+        }
+        const int sibling = (m_nodes[parent].left == leaf) ? m_nodes[parent].right : m_nodes[parent].left;
+        const int grandParent = findParent(parent);
+        if (grandParent < 0) {
+            m_root = sibling;
+        } else if (m_nodes[grandParent].left == parent) {
+            m_nodes[grandParent].left = sibling;
+        } else {
+            m_nodes[grandParent].right = sibling;
+        }
+        // Detach the parent so findParent no longer sees it, compact() drops it
+        m_nodes[parent].left = -1;
+        m_nodes[parent].right = -1;
+    }
+    bool changed = !deadLeaves.empty();
+    if (changed) compact();
+
+    // 2. New objects, in list order
+    for (const SDFObject& object : objects) {
+        if (leafIds.count(object.id)) continue;
+        int leaf = addLeaf(object.id);
+        m_root = (m_root < 0) ? leaf : addOperation(CSGOperation::UNION, -1.0f, m_root, leaf);
+        leafIds.insert(object.id);
+        changed = true;
+    }
+
+    if (changed) markChanged();
+    return changed;
+}
+
+bool CSGTree::isPlainUnion(const std::vector<SDFObject>& objects) const {
+    if (objects.empty()) return m_root < 0;
+    int node = m_root;
+    for (int i = static_cast<int>(objects.size()) - 1; i > 0; --i) {
+        if (node < 0 || m_nodes[node].isLeaf()) return false;
+        const Node& join = m_nodes[node];
+        if (join.operation != CSGOperation::UNION || join.smoothness >= 0.0f) return false;
+        const Node& right = m_nodes[join.right];
+        if (!right.isLeaf() || right.objectId != objects[i].id) return false;
+        node = join.left;
+    }
+    return node >= 0 && m_nodes[node].isLeaf() && m_nodes[node].objectId == objects[0].id;
+}
+
+float CSGTree::getMaxSmoothness(float sceneSmoothness) const {
+    float maxSmoothness = sceneSmoothness;
+    for (const Node& node : m_nodes) {
+        if (!node.isLeaf() && node.operation == CSGOperation::UNION) maxSmoothness = std::max(maxSmoothness, node.smoothness);
+    }
+    return maxSmoothness;
+}
+
+bool CSGTree::compile(const std::vector<SDFObject>& objects, float sceneSmoothness, std::vector<CSGInstruction>& outProgram) const {
+    outProgram.clear();
+    if (m_root < 0 || isPlainUnion(objects)) return true;
+
+    std::unordered_map<int, int> indexOfId;
+    for (size_t i = 0; i < objects.size(); ++i) indexOfId[objects[i].id] = static_cast<int>(i);
+
+    // Post-order without recursion (left-deep chains are as deep as the scene is large)
+    std::vector<std::pair<int, bool>> pending;
+    pending.push_back({m_root, false});
+    int depth = 0;
+    while (!pending.empty()) {
+        auto [nodeIndex, childrenDone] = pending.back();
+        pending.pop_back();
+        const Node& node = m_nodes[nodeIndex];
+
+        if (node.isLeaf()) {
+            auto found = indexOfId.find(node.objectId);
+            if (found == indexOfId.end()) {
+                std::cerr << "ERROR::CSG::COMPILE object " << node.objectId << " is not in the scene" << std::endl;
+                outProgram.clear();
+                return false;
+            }
+            if (++depth > CSG_STACK_SIZE) {
+                std::cerr << "ERROR::CSG::COMPILE tree needs more than " << CSG_STACK_SIZE << " stack entries" << std::endl;
+                outProgram.clear();
+                return false;
+            }
+            outProgram.push_back(makeCSGPush(found->second));
+        } else if (childrenDone) {
+            const uint32_t opcode = (node.operation == CSGOperation::SUBTRACT) ? CSG_SUBTRACT
+                                  : (node.operation == CSGOperation::INTERSECT) ? CSG_INTERSECT : CSG_UNION;
+            outProgram.push_back(CSGInstruction{opcode, node.smoothness < 0.0f ? sceneSmoothness : node.smoothness});
+            --depth;
+        } else {
+            pending.push_back({nodeIndex, true});
+            pending.push_back({node.right, false});
+            pending.push_back({node.left, false});
+        }
+    }
+    return true;
+}
@@ -0,0 +1,105 @@
+//
+// Scene composition: a binary tree of union / subtract / intersect nodes over the objects, each with its own
+// smooth k. Compiled to a postfix program (CSGInstruction) that raymarch.frag and SDFEvaluator both interpret,
+// so a structural edit re-uploads a few bytes per node instead of touching the shader.
+//
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Basic/SDFObject.h"
+
+enum class CSGOperation : int {
+    UNION = 0,
+    SUBTRACT = 1,   // left minus right
+    INTERSECT = 2
+};
+
+// Opcodes in bits 0-7 of CSGInstruction::opcode, must match raymarch.frag
+enum CSGOpcode : uint32_t {
+    CSG_PUSH = 0,       // Bits 8-31: object index, pushes that object's distance
+    CSG_UNION = 1,      // The binary ops pop the top two entries (a below b) and push the result
+    CSG_SUBTRACT = 2,
+    CSG_INTERSECT = 3
+};
+
+constexpr uint32_t CSG_OPCODE_MASK = 0xFFu;
+constexpr int CSG_STACK_SIZE = 8; // Entries the interpreters keep, must match raymarch.frag
+
+// One postfix instruction, std430 layout of CSGInstruction in raymarch.frag (8 bytes)
+struct CSGInstruction {
+    uint32_t opcode;
+    float smoothness;   // k of a binary op, 0 = sharp
+};
+static_assert(sizeof(CSGInstruction) == 8, "Must match the std430 CSGInstruction in raymarch.frag");
+
+inline bool operator==(const CSGInstruction& a, const CSGInstruction& b) {
+    return a.opcode == b.opcode && a.smoothness == b.smoothness;
+}
+
+inline CSGInstruction makeCSGPush(int objectIndex) {
+    return CSGInstruction{CSG_PUSH | (static_cast<uint32_t>(objectIndex) << 8), 0.0f};
+}
+
+// Renumbers the objects a program pushes, e.g. from list order to SDFObjectBuffer order: object i becomes newIndex[i]
+inline void remapCSGObjects(std::vector<CSGInstruction>& program, const std::vector<int>& newIndex) {
+    for (CSGInstruction& instruction : program) {
+        if ((instruction.opcode & CSG_OPCODE_MASK) != CSG_PUSH) continue;
+        const size_t objectIndex = instruction.opcode >> 8;
+        if (objectIndex < newIndex.size()) instruction = makeCSGPush(newIndex[objectIndex]);
+    }
+}
+
+class CSGTree {
+public:
+    struct Node {
+        CSGOperation operation = CSGOperation::UNION;  // Inner nodes
+        float smoothness = -1.0f;                      // k, below 0 = the scene's blend smoothness
+        int objectId = -1;                             // Leaves: SDFObject::id, -1 for inner nodes
+        int left = -1;
+        int right = -1;
+
+        bool isLeaf() const { return objectId >= 0; }
+    };
+
+    // Follows the object list: new objects are unioned onto the root with the scene smoothness, leaves of
+    // deleted objects are dropped (their parent is replaced by the sibling). Returns true if the tree changed
+    bool syncObjects(const std::vector<SDFObject>& objects);
+
+    // Building blocks, the caller wires them up and calls setRoot
+    int addLeaf(int objectId);
+    int addOperation(CSGOperation operation, float smoothness, int left, int right);
+    void setRoot(int node) { m_root = node; markChanged(); }
+    void clear();
+
+    int getRoot() const { return m_root; }
+    const std::vector<Node>& getNodes() const { return m_nodes; }
+    Node& getNode(int node) { return m_nodes[node]; }
+
+    // The operation that combines the object with the shapes before it (its leaf is the right child),
+    // nullptr if the object is a left operand (e.g. the first object) or has no leaf
+    Node* findJoinOf(int objectId);
+
+    // The implicit scene: a left-deep union chain over the objects in list order, all with the scene smoothness
+    bool isPlainUnion(const std::vector<SDFObject>& objects) const;
+
+    // Largest k any union can bulge the surface by (for bounds), at least sceneSmoothness
+    float getMaxSmoothness(float sceneSmoothness) const;
+
+    // Postfix program with object indices into 'objects' and every k resolved. Plain union scenes compile to an
+    // empty program and render with the renderers' culled, blend group aware smooth union; any other tree blends
+    // pairwise and ignores blend groups. Returns false (and an empty program) if the tree needs more than
+    // CSG_STACK_SIZE entries or references a missing object
+    bool compile(const std::vector<SDFObject>& objects, float sceneSmoothness, std::vector<CSGInstruction>& outProgram) const;
+
+    // Bumped by every edit, callers compare it to know when to compile again
+    uint64_t getVersion() const { return m_version; }
+    void markChanged() { ++m_version; }
+
+private:
+    int findParent(int node) const;
+    void compact();
+
+    std::vector<Node> m_nodes;
+    int m_root = -1;
+    uint64_t m_version = 1;
+};
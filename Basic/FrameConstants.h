@@ -0,0 +1,34 @@
+//
+// Per-frame shader inputs, mirrors the std140 FrameBlock in raymarch.frag (binding 1).
+// Written once per frame into a PersistentRingBuffer slot instead of individual glUniform calls.
+//
+#pragma once
+#include <glm/glm.hpp>
+
+struct FrameConstants {
+    glm::vec4 cameraBasis[3];     // mat3 u_cameraBasis, std140 pads every column to a vec4
+    glm::vec3 cameraPos;          // u_cameraPos
+    float fov;                    // u_fov (degrees)
+    glm::vec3 clearColor;         // u_clearColor
+    float blendSmoothness;        // u_blendSmoothness
+    glm::vec2 resolution;         // u_resolution
+    int sdfCount;                 // u_sdfCount
+    int selectedObjectID;         // u_selectedObjectID (index, -1 for none)
+    int debugMode;                // u_debugMode
+    int bvhNodeCount;             // u_bvhNodeCount, 0 disables the BVH
+    int cullingMode;              // u_cullingMode, CullingMode in AstralUI.h
+    int tileSize;                 // u_tileSize, pixels per tile side
+    int tilesX;                   // u_tilesX, tiles per row
+    int hoveredObjectID;          // u_hoveredObjectID (index, -1 for none)
+    int normalMethod;             // u_normalMethod, NormalMethod in AstralUI.h
+    float relaxation;             // u_relaxation, sphere tracing over-relaxation (1 = off)
+    int stepsCompare;             // u_stepsCompare, split the Steps view (left: original march)
+    int maxSteps;                 // u_maxSteps, step budget per pixel
+    float coneScale;              // u_coneScale, hit epsilon in pixel footprints (0 = fixed)
+    int csgLength;                // u_csgLength, CSG instructions (0 = plain smooth union of every object)
+    glm::vec3 sceneBoundsMin;     // u_sceneBoundsMin, AABB of every surface (blend radius included)
+    int lighting;                 // u_lighting, 0 = unlit base color
+    glm::vec3 sceneBoundsMax;     // u_sceneBoundsMax, below min when the scene is empty
+    int selectionHighlight;       // u_selectionHighlight, 0 = no selection / hover tint
+};
+static_assert(sizeof(FrameConstants) == 176, "Must match the std140 FrameBlock in raymarch.frag");
@@ -0,0 +1,79 @@
+//
+// Triple-buffered persistent mapping
+//
+
+#include "PersistentRingBuffer.h"
+#include <algorithm>
+#include <iostream>
+
+PersistentRingBuffer::~PersistentRingBuffer() {
+    destroy();
+}
+
+bool PersistentRingBuffer::create(GLenum target, GLsizeiptr slotSize) {
+    destroy();
+
+    GLint alignment = 256;
+    glGetIntegerv(target == GL_UNIFORM_BUFFER ? GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT : GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    alignment = std::max(alignment, 1);
+
+    m_target = target;
+    m_slotSize = (std::max<GLsizeiptr>(slotSize, 1) + alignment - 1) / alignment * alignment;
+
+    // Coherent: writes become visible to the GPU without explicit flushes
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glGenBuffers(1, &m_buffer);
+    glBindBuffer(m_target, m_buffer);
+    glBufferStorage(m_target, m_slotSize * SLOT_COUNT, nullptr, flags);
+    m_mapped = static_cast<char*>(glMapBufferRange(m_target, 0, m_slotSize * SLOT_COUNT, flags));
+    glBindBuffer(m_target, 0);
+
+    if (!m_mapped) {
+        std::cerr << "ERROR::RING_BUFFER::MAPPING_FAILED (" << m_slotSize * SLOT_COUNT << " bytes)" << std::endl;
+        destroy();
+        return false;
+    }
+    m_slot = SLOT_COUNT - 1; // First acquireSlot() returns slot 0
+    return true;
+}
+
+void PersistentRingBuffer::destroy() {
+    for (GLsync& fence : m_fences) {
+        if (fence) { glDeleteSync(fence); fence = nullptr; }
+    }
+    if (m_buffer) {
+        // Deleting the buffer also unmaps it, the driver keeps it alive while in-flight frames still read it
+        glDeleteBuffers(1, &m_buffer);
+        m_buffer = 0;
+    }
+    m_mapped = nullptr;
+    m_slotSize = 0;
+}
+
+void* PersistentRingBuffer::acquireSlot() {
+    m_slot = (m_slot + 1) % SLOT_COUNT;
+
+    GLsync& fence = m_fences[m_slot];
+    if (fence) {
+        // Normally signalled long ago, only blocks when the GPU is SLOT_COUNT frames behind
+        GLenum status = glClientWaitSync(fence, 0, 0);
+        if (status == GL_TIMEOUT_EXPIRED) {
+            ++m_stallCount;
+            do {
+                status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ull);
+            } while (status == GL_TIMEOUT_EXPIRED);
+        }
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+    return m_mapped + m_slot * m_slotSize;
+}
+
+void PersistentRingBuffer::bindSlot(GLuint bindingPoint) const {
+    glBindBufferRange(m_target, bindingPoint, m_buffer, m_slot * m_slotSize, m_slotSize);
+}
+
+void PersistentRingBuffer::fenceSlot() {
+    if (m_fences[m_slot]) glDeleteSync(m_fences[m_slot]);
+    m_fences[m_slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
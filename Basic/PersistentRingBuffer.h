@@ -0,0 +1,43 @@
+//
+// Persistently mapped buffer split into SLOT_COUNT slots, one per frame in flight.
+// The CPU writes slot N while the GPU may still read slots N-1 and N-2; every slot is guarded by a fence,
+// so a write only has to wait if the GPU falls more than SLOT_COUNT frames behind.
+//
+#pragma once
+#include <glad/glad.h>
+
+class PersistentRingBuffer {
+public:
+    static constexpr int SLOT_COUNT = 3;
+
+    PersistentRingBuffer() = default;
+    ~PersistentRingBuffer();
+
+    PersistentRingBuffer(const PersistentRingBuffer&) = delete;
+    PersistentRingBuffer& operator=(const PersistentRingBuffer&) = delete;
+
+    // target is GL_UNIFORM_BUFFER or GL_SHADER_STORAGE_BUFFER, slotSize is rounded up to its offset alignment
+    bool create(GLenum target, GLsizeiptr slotSize);
+    void destroy();
+
+    // Moves to the next slot and returns its mapped (write-only) memory, waiting on the slot's fence if needed
+    void* acquireSlot();
+    // Binds the current slot to an indexed binding point
+    void bindSlot(GLuint bindingPoint) const;
+    // Call after the draw calls that read the current slot
+    void fenceSlot();
+
+    bool isCreated() const { return m_buffer != 0; }
+    int getSlotIndex() const { return m_slot; }
+    GLsizeiptr getSlotSize() const { return m_slotSize; }
+    int getStallCount() const { return m_stallCount; } // Times acquireSlot() had to wait for the GPU
+
+private:
+    GLenum m_target = GL_UNIFORM_BUFFER;
+    GLuint m_buffer = 0;
+    GLsizeiptr m_slotSize = 0;
+    char* m_mapped = nullptr;
+    GLsync m_fences[SLOT_COUNT] = {};
+    int m_slot = 0;
+    int m_stallCount = 0;
+};
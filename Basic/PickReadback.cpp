@@ -0,0 +1,83 @@
+//
+// PBO ring for picking reads
+//
+
+#include "PickReadback.h"
+
+PickReadback::~PickReadback() {
+    destroy();
+}
+
+void PickReadback::init() {
+    if (m_initialized) return;
+    for (Slot& slot : m_slots) {
+        glGenBuffers(1, &slot.pbo);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+        glBufferData(GL_PIXEL_PACK_BUFFER, sizeof(GLint), nullptr, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    m_initialized = true;
+}
+
+void PickReadback::destroy() {
+    if (!m_initialized) return;
+    for (Slot& slot : m_slots) {
+        if (slot.fence) { glDeleteSync(slot.fence); slot.fence = nullptr; }
+        glDeleteBuffers(1, &slot.pbo);
+        slot.pbo = 0;
+    }
+    m_initialized = false;
+}
+
+bool PickReadback::request(int x, int y, Purpose purpose) {
+    if (!m_initialized) return false;
+
+    Slot* freeSlot = nullptr;
+    for (Slot& slot : m_slots) {
+        if (!slot.fence) { freeSlot = &slot; break; }
+    }
+    if (!freeSlot) return false;
+
+    // With a pack buffer bound, glReadPixels only queues the copy and returns immediately
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, freeSlot->pbo);
+    glReadPixels(x, y, 1, 1, GL_RED_INTEGER, GL_INT, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    freeSlot->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    freeSlot->purpose = purpose;
+    freeSlot->sequence = m_nextSequence++;
+    return true;
+}
+
+bool PickReadback::poll(Result& outResult) {
+    if (!m_initialized) return false;
+
+    Slot* oldest = nullptr;
+    for (Slot& slot : m_slots) {
+        if (slot.fence && (!oldest || slot.sequence < oldest->sequence)) oldest = &slot;
+    }
+    if (!oldest) return false;
+
+    // Zero timeout: just ask. The flush makes sure the fence actually reaches the GPU
+    GLenum status = glClientWaitSync(oldest->fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) return false;
+
+    GLint value = -1;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, oldest->pbo);
+    glGetBufferSubData(GL_PIXEL_PACK_BUFFER, 0, sizeof(GLint), &value);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    glDeleteSync(oldest->fence);
+    oldest->fence = nullptr;
+
+    outResult.value = value;
+    outResult.purpose = oldest->purpose;
+    return true;
+}
+
+bool PickReadback::hasPending() const {
+    for (const Slot& slot : m_slots) {
+        if (slot.fence) return true;
+    }
+    return false;
+}
@@ -0,0 +1,51 @@
+//
+// Asynchronous single-pixel reads of the picking texture.
+// glReadPixels goes into a pixel buffer object and a fence; poll() hands the value back once the fence has
+// signalled (usually one or two frames later), so a click never makes the CPU wait for the GPU.
+//
+#pragma once
+#include <glad/glad.h>
+#include <array>
+#include <cstdint>
+
+class PickReadback {
+public:
+    static constexpr int RING_SIZE = 4; // Reads in flight at once
+
+    enum class Purpose { CLICK, HOVER };
+
+    struct Result {
+        int value = -1;   // out_ObjectID at the pixel (object index, -1 for background)
+        Purpose purpose = Purpose::CLICK;
+    };
+
+    PickReadback() = default;
+    ~PickReadback();
+
+    PickReadback(const PickReadback&) = delete;
+    PickReadback& operator=(const PickReadback&) = delete;
+
+    void init();
+    void destroy();
+
+    // Queues a read of pixel (x, y) (GL coordinates, bottom-left origin) from the bound GL_READ_FRAMEBUFFER's read buffer.
+    // Returns false when every slot is still in flight
+    bool request(int x, int y, Purpose purpose);
+
+    // Oldest finished read, without waiting. Returns false if none is ready yet
+    bool poll(Result& outResult);
+
+    bool hasPending() const;
+
+private:
+    struct Slot {
+        GLuint pbo = 0;
+        GLsync fence = nullptr;
+        Purpose purpose = Purpose::CLICK;
+        uint64_t sequence = 0; // Request order, results are delivered oldest first
+    };
+
+    std::array<Slot, RING_SIZE> m_slots;
+    uint64_t m_nextSequence = 1;
+    bool m_initialized = false;
+};
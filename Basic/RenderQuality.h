@@ -0,0 +1,39 @@
+//
+// Raymarch quality presets: how many steps a pixel may take and how coarse the hit test may get with distance.
+// Shared by the editor (RenderParams) and the headless renderer.
+//
+#pragma once
+#include <cstring>
+
+enum class QualityPreset : int {
+    DRAFT = 0,
+    BALANCED = 1,
+    HIGH = 2,
+    REFERENCE = 3   // The original fixed 0.001 threshold and 500 steps
+};
+
+struct QualitySettings {
+    const char* name;
+    int maxSteps;       // u_maxSteps, step budget per pixel
+    float coneScale;    // u_coneScale, hit epsilon in pixel footprints (0 = fixed threshold)
+};
+
+inline QualitySettings getQualitySettings(QualityPreset preset) {
+    switch (preset) {
+        case QualityPreset::DRAFT:     return {"Draft", 96, 2.0f};
+        case QualityPreset::BALANCED:  return {"Balanced", 200, 1.0f};
+        case QualityPreset::HIGH:      return {"High", 320, 0.5f};
+        default:                       return {"Reference", 500, 0.0f};
+    }
+}
+
+// Case sensitive name lookup, returns false if no preset has that name
+inline bool findQualityPreset(const char* name, QualityPreset& outPreset) {
+    for (int i = 0; i <= static_cast<int>(QualityPreset::REFERENCE); ++i) {
+        if (std::strcmp(getQualitySettings(static_cast<QualityPreset>(i)).name, name) == 0) {
+            outPreset = static_cast<QualityPreset>(i);
+            return true;
+        }
+    }
+    return false;
+}
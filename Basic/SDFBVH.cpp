@@ -0,0 +1,81 @@
+//
+// Median-split BVH build and bottom-up refit
+//
+
+#include "SDFBVH.h"
+#include <algorithm>
+
+using namespace glm;
+
+void SDFBVH::build(const std::vector<SDFObjectGPUData>& objects) {
+    const int count = static_cast<int>(objects.size());
+    m_nodes.clear();
+    m_parents.clear();
+    m_leafOfObject.assign(count, -1);
+    if (count == 0) return;
+
+    m_objectMin.resize(count);
+    m_objectMax.resize(count);
+    m_centroids.resize(count);
+    m_order.resize(count);
+    for (int i = 0; i < count; ++i) {
+        getWorldBounds(objects[i], m_objectMin[i], m_objectMax[i]);
+        m_centroids[i] = (m_objectMin[i] + m_objectMax[i]) * 0.5f;
+        m_order[i] = i;
+    }
+
+    m_nodes.reserve(2 * count - 1);
+    m_parents.reserve(2 * count - 1);
+    buildRange(0, count, -1);
+}
+
+int SDFBVH::buildRange(int begin, int end, int parent) {
+    const int nodeIndex = static_cast<int>(m_nodes.size());
+    m_nodes.push_back(BVHNode{});
+    m_parents.push_back(parent);
+
+    if (end - begin == 1) {
+        const int object = m_order[begin];
+        m_nodes[nodeIndex] = BVHNode{m_objectMin[object], object, m_objectMax[object], -1};
+        m_leafOfObject[object] = nodeIndex;
+        return nodeIndex;
+    }
+
+    // Split at the median centroid along the widest axis, keeps the depth at log2(n)
+    vec3 centroidMin = m_centroids[m_order[begin]];
+    vec3 centroidMax = centroidMin;
+    for (int i = begin + 1; i < end; ++i) {
+        centroidMin = min(centroidMin, m_centroids[m_order[i]]);
+        centroidMax = max(centroidMax, m_centroids[m_order[i]]);
+    }
+    vec3 size = centroidMax - centroidMin;
+    int axis = (size.x > size.y && size.x > size.z) ? 0 : (size.y > size.z ? 1 : 2);
+
+    const int mid = begin + (end - begin) / 2;
+    std::nth_element(m_order.begin() + begin, m_order.begin() + mid, m_order.begin() + end,
+                     [&](int a, int b) { return m_centroids[a][axis] < m_centroids[b][axis]; });
+
+    const int left = buildRange(begin, mid, nodeIndex);
+    const int right = buildRange(mid, end, nodeIndex);
+    m_nodes[nodeIndex] = BVHNode{min(m_nodes[left].boundsMin, m_nodes[right].boundsMin), left,
+                                 max(m_nodes[left].boundsMax, m_nodes[right].boundsMax), right};
+    return nodeIndex;
+}
+
+void SDFBVH::refit(const std::vector<SDFObjectGPUData>& objects, const std::vector<int>& changedIndices) {
+    for (int object : changedIndices) {
+        if (object < 0 || object >= static_cast<int>(m_leafOfObject.size())) continue;
+
+        int node = m_leafOfObject[object];
+        getWorldBounds(objects[object], m_nodes[node].boundsMin, m_nodes[node].boundsMax);
+
+        // Walk up, each ancestor becomes the union of its two children again
+        for (node = m_parents[node]; node != -1; node = m_parents[node]) {
+            BVHNode& inner = m_nodes[node];
+            const BVHNode& left = m_nodes[inner.leftOrObject];
+            const BVHNode& right = m_nodes[inner.right];
+            inner.boundsMin = min(left.boundsMin, right.boundsMin);
+            inner.boundsMax = max(left.boundsMax, right.boundsMax);
+        }
+    }
+}
@@ -0,0 +1,47 @@
+//
+// Bounding volume hierarchy over the objects' world-space AABBs, one object per leaf.
+// Uploaded as the BVHBlock SSBO; mapTheWorld uses it to skip objects too far away to affect the blend.
+// The blend radius is added while traversing, so changing u_blendSmoothness needs no rebuild.
+//
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+#include "Basic/SDFObject.h"
+
+// Matches BVHNode in raymarch.frag (std430)
+struct BVHNode {
+    glm::vec3 boundsMin;
+    int leftOrObject;    // Inner node: left child index, leaf: object index
+    glm::vec3 boundsMax;
+    int right;           // Inner node: right child index, leaf: -1
+};
+static_assert(sizeof(BVHNode) == 32, "Must match the std430 BVHNode in raymarch.frag");
+
+class SDFBVH {
+public:
+    // Full rebuild, needed whenever objects are added, removed or reordered. Leaves hold indices into 'objects'
+    void build(const std::vector<SDFObjectGPUData>& objects);
+    // Updates the bounds of the changed objects and their ancestors, the tree shape stays the same
+    void refit(const std::vector<SDFObjectGPUData>& objects, const std::vector<int>& changedIndices);
+
+    const std::vector<BVHNode>& getNodes() const { return m_nodes; }
+    int getNodeCount() const { return static_cast<int>(m_nodes.size()); }
+    // Root bounds, the AABB of the whole scene (false if there are no objects)
+    bool getSceneBounds(glm::vec3& outMin, glm::vec3& outMax) const {
+        if (m_nodes.empty()) return false;
+        outMin = m_nodes[0].boundsMin;
+        outMax = m_nodes[0].boundsMax;
+        return true;
+    }
+
+private:
+    int buildRange(int begin, int end, int parent);
+
+    std::vector<BVHNode> m_nodes;       // Root is node 0
+    std::vector<int> m_parents;         // Per node, -1 for the root
+    std::vector<int> m_leafOfObject;    // Per object, its leaf node
+
+    // Build scratch
+    std::vector<int> m_order;
+    std::vector<glm::vec3> m_objectMin, m_objectMax, m_centroids;
+};
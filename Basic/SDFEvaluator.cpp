@@ -0,0 +1,419 @@
+//
+// CPU reference evaluator, scalar path and runtime ISA dispatch
+//
+
+#include "SDFEvaluator.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(ASTRAL_SIMD_X86) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+using namespace glm;
+
+// Smooth minimum, returns (blended distance, h)
+static vec2 sminVerbose(float distA, float distB, float k) {
+    float h = clamp(0.5f + 0.5f * (distA - distB) / k, 0.0f, 1.0f);
+    float blendedDist = mix(distA, distB, h) - k * h * (1.0f - h);
+    return vec2(blendedDist, h);
+}
+
+// Order independent smooth union of one blend group, same as BlendGroup in raymarch.frag: sums relative to the
+// group's nearest object, hard min into the result when the group is closed
+struct BlendGroup {
+    int id = -1;
+    float nearest = sdfkernels::MAX_DIST;
+    float weightSum = 0.0f;
+    vec3 color = vec3(0.0f);
+    vec3 gradient = vec3(0.0f);
+    int objectIndex = -1;
+};
+
+static void closeBlendGroup(SDFSample& res, vec3* outGradient, const BlendGroup& group, float k) {
+    if (group.objectIndex < 0) return;
+    float dist = group.nearest - std::max(k, sdfkernels::BLEND_MIN_K) * sdfkernels::BLEND_EXP_SCALE * std::log(group.weightSum);
+    if (dist < res.dist) {
+        res.dist = dist;
+        res.color = group.color / group.weightSum;
+        res.objectIndex = group.objectIndex;
+        if (outGradient) *outGradient = group.gradient / group.weightSum;
+    }
+}
+
+static void blendDistance(SDFSample& res, vec3* outGradient, BlendGroup& group, int i, int groupId, float dist,
+                          const vec3& gradient, const vec3& color, float k) {
+    if (groupId != group.id) {
+        closeBlendGroup(res, outGradient, group, k);
+        group = BlendGroup{};
+        group.id = groupId;
+    }
+    const float ke = std::max(k, sdfkernels::BLEND_MIN_K) * sdfkernels::BLEND_EXP_SCALE;
+    if (dist < group.nearest) {
+        // New nearest object: the sums so far are rescaled to it
+        const float scale = std::exp((dist - group.nearest) / ke);
+        group.weightSum = group.weightSum * scale + 1.0f;
+        group.color = group.color * scale + color;
+        group.gradient = group.gradient * scale + gradient;
+        group.nearest = dist;
+        group.objectIndex = i;
+    } else {
+        const float weight = std::exp((group.nearest - dist) / ke);
+        group.weightSum += weight;
+        group.color += weight * color;
+        group.gradient += weight * gradient;
+    }
+}
+
+// Combines b (stack top) into a (below it), same as csgCombine in raymarch.frag.
+// Intersection is max(a, b) = -min(-a, -b), subtraction is max(a, -b); the cut surface keeps a's color and index
+static void combineCSG(SDFSample& a, vec3& gradientA, SDFSample b, vec3 gradientB, uint32_t opcode, float k) {
+    if (opcode == CSG_SUBTRACT) {
+        b.dist = -b.dist;
+        gradientB = -gradientB;
+    }
+    const float side = (opcode == CSG_UNION) ? 1.0f : -1.0f;
+    float dist, h;
+    if (k > 0.0f) {
+        vec2 blendResult = sminVerbose(side * a.dist, side * b.dist, k);
+        dist = side * blendResult.x;
+        h = blendResult.y;
+    } else {
+        h = (side * a.dist > side * b.dist) ? 1.0f : 0.0f;
+        dist = mix(a.dist, b.dist, h);
+    }
+    a.dist = dist;
+    gradientA = mix(gradientA, gradientB, h);
+    if (opcode != CSG_SUBTRACT) {
+        a.color = mix(a.color, b.color, h);
+        if (h > 0.5f) a.objectIndex = b.objectIndex;
+    }
+}
+
+SDFEvaluator::SDFEvaluator() : m_isa(detectISA()) {}
+
+void SDFEvaluator::setObjects(const std::vector<SDFObjectGPUData>& objects) {
+    m_objects = objects;
+    m_prepared.resize(objects.size());
+    m_lipschitz = 1.0f;
+
+    for (size_t i = 0; i < objects.size(); ++i) {
+        const SDFObjectGPUData& src = objects[i];
+        sdfkernels::PreparedObject& dst = m_prepared[i];
+
+        // Rebuild the inverse transform from the quaternion: row r of the inverse rotation is the rotated
+        // axis r, and the translation column moves the position to the origin
+        for (int row = 0; row < 3; ++row) {
+            vec3 axis = vec3(0.0f);
+            axis[row] = 1.0f;
+            vec3 rotatedAxis = quatRotate(src.rotation, axis);
+            for (int col = 0; col < 3; ++col) dst.rows[row][col] = rotatedAxis[col];
+            dst.rows[row][3] = -dot(rotatedAxis, src.position);
+        }
+
+        vec3 params = src.parameters;
+        vec3 clampedRadii = max(params, vec3(1e-6f));
+        // The rounded box lanes evaluate the inner box and subtract the corner radius, same as sdRoundedBoxLocal
+        dst.radius = 0.0f;
+        if (getObjectType(src) == static_cast<int>(SDFType::ROUNDED_BOX)) {
+            dst.radius = clamp(getPrimitiveParameters(src).w, 0.0f, 1.0f) * min(params.x, min(params.y, params.z));
+            params -= vec3(dst.radius);
+        }
+        vec4 colorLipschitz = unpackColorLipschitz(src);
+        for (int c = 0; c < 3; ++c) {
+            dst.params[c] = params[c];
+            dst.invParams[c] = 1.0f / clampedRadii[c];
+            dst.invParamsSq[c] = 1.0f / (clampedRadii[c] * clampedRadii[c]);
+            dst.color[c] = colorLipschitz[c];
+            dst.sphere[c] = src.position[c];
+        }
+        dst.paramsLength = length(clampedRadii);
+        m_lipschitz = std::max(m_lipschitz, colorLipschitz.w);
+        dst.type = getObjectType(src);
+        dst.blendGroup = getBlendGroup(src);
+        dst.sphere[3] = getBoundingRadius(src);
+    }
+}
+
+SDFSample SDFEvaluator::evaluateObject(int i, const vec3& p, vec3* outGradient) const {
+    const SDFObjectGPUData& obj = m_objects[i];
+    vec4 invRotation = vec4(-obj.rotation.x, -obj.rotation.y, -obj.rotation.z, obj.rotation.w);
+    vec3 pLocal = quatRotate(invRotation, p - obj.position);
+
+    SDFSample res;
+    res.color = vec3(unpackColorLipschitz(obj));
+    res.objectIndex = i;
+    // Unknown types are never hit, same as evaluatePrimitive in the shader
+    const SDFPrimitive* primitive = SDFPrimitives::find(getObjectType(obj));
+    if (!primitive) {
+        if (outGradient) *outGradient = vec3(0.0f);
+        return res;
+    }
+    if (outGradient) {
+        vec4 distGrad = primitive->distanceGradient(pLocal, getPrimitiveParameters(obj));
+        res.dist = distGrad.x;
+        *outGradient = quatRotate(obj.rotation, vec3(distGrad.y, distGrad.z, distGrad.w));
+    } else {
+        res.dist = primitive->distance(pLocal, getPrimitiveParameters(obj));
+    }
+    return res;
+}
+
+SDFSample SDFEvaluator::evaluateCSG(const std::vector<CSGInstruction>& program, const vec3& p, vec3* outGradient) const {
+    SDFSample stack[CSG_STACK_SIZE];
+    vec3 gradients[CSG_STACK_SIZE];
+    int top = 0;
+    for (const CSGInstruction& instruction : program) {
+        const uint32_t opcode = instruction.opcode & CSG_OPCODE_MASK;
+        if (opcode == CSG_PUSH) {
+            const int objectIndex = static_cast<int>(instruction.opcode >> 8);
+            if (top == CSG_STACK_SIZE || objectIndex >= static_cast<int>(m_objects.size())) break; // Malformed program
+            gradients[top] = vec3(0.0f);
+            stack[top] = evaluateObject(objectIndex, p, outGradient ? &gradients[top] : nullptr);
+            ++top;
+        } else {
+            if (top < 2) break;
+            --top;
+            combineCSG(stack[top - 1], gradients[top - 1], stack[top], gradients[top], opcode, instruction.smoothness);
+        }
+    }
+
+    if (top == 0) {
+        SDFSample empty;
+        empty.color = m_clearColor;
+        if (outGradient) *outGradient = vec3(0.0f);
+        return empty;
+    }
+    if (outGradient) *outGradient = gradients[0];
+    return stack[0];
+}
+
+void SDFEvaluator::pruneCSG(const std::vector<CSGInstruction>& tape, const vec3& boxMin, const vec3& boxMax,
+                            std::vector<CSGInstruction>& outTape) const {
+    // Stack entry: the interval of its distance over the box and where its instructions start in outTape.
+    // Operands are contiguous in postfix, so a is [a.start, b.start) and b runs to the end of outTape
+    struct Entry {
+        float lo;
+        float hi;
+        size_t start;
+    };
+    Entry stack[CSG_STACK_SIZE];
+    int top = 0;
+    outTape.clear();
+
+    const vec3 center = 0.5f * (boxMin + boxMax);
+    const float halfDiagonal = 0.5f * length(boxMax - boxMin);
+    for (const CSGInstruction& instruction : tape) {
+        const uint32_t opcode = instruction.opcode & CSG_OPCODE_MASK;
+        if (opcode == CSG_PUSH) {
+            const int objectIndex = static_cast<int>(instruction.opcode >> 8);
+            if (top == CSG_STACK_SIZE || objectIndex >= static_cast<int>(m_objects.size())) { // Malformed, keep it all
+                outTape = tape;
+                return;
+            }
+            // An exact distance changes by at most the distance moved, so the center value bounds it over the box,
+            // and it is never below the distance to the bounding sphere. The others (elongated ellipsoids) bound
+            // nothing: their packed Lipschitz value only caps how much they overestimate, not their slope. It is
+            // exactly 1 for exact primitives and for round ellipsoids, whose formula is the sphere distance
+            float lo = -std::numeric_limits<float>::infinity();
+            float hi = std::numeric_limits<float>::infinity();
+            const SDFPrimitive* primitive = SDFPrimitives::find(getObjectType(m_objects[objectIndex]));
+            if (primitive && unpackColorLipschitz(m_objects[objectIndex]).w == 1.0f) {
+                const sdfkernels::PreparedObject& prepared = m_prepared[objectIndex];
+                const vec3 sphereCenter = vec3(prepared.sphere[0], prepared.sphere[1], prepared.sphere[2]);
+                const float centerDist = evaluateObject(objectIndex, center, nullptr).dist;
+                lo = std::max(centerDist - halfDiagonal, length(max(max(boxMin - sphereCenter, sphereCenter - boxMax), vec3(0.0f))) - prepared.sphere[3]);
+                hi = centerDist + halfDiagonal;
+            }
+            stack[top] = Entry{lo, hi, outTape.size()};
+            outTape.push_back(instruction);
+            ++top;
+            continue;
+        }
+        if (top < 2) {
+            outTape = tape;
+            return;
+        }
+        --top;
+        Entry& a = stack[top - 1];
+        const Entry& b = stack[top];
+        const float k = instruction.smoothness;
+
+        // One operand decides the op everywhere in the box when the other stays k past it: the blend weight h is
+        // then exactly 0 or 1 (see combineCSG), so dropping the other operand changes nothing
+        if (opcode == CSG_UNION) {
+            if (a.hi + k <= b.lo) {
+                outTape.resize(b.start);
+            } else if (b.hi + k <= a.lo) {
+                outTape.erase(outTape.begin() + static_cast<std::ptrdiff_t>(a.start), outTape.begin() + static_cast<std::ptrdiff_t>(b.start));
+                a = Entry{b.lo, b.hi, a.start};
+            } else {
+                a = Entry{std::min(a.lo, b.lo) - 0.25f * k, std::min(a.hi, b.hi), a.start};
+                outTape.push_back(instruction);
+            }
+        } else if (opcode == CSG_INTERSECT) {
+            if (a.lo >= b.hi + k) {
+                outTape.resize(b.start);
+            } else if (b.lo >= a.hi + k) {
+                outTape.erase(outTape.begin() + static_cast<std::ptrdiff_t>(a.start), outTape.begin() + static_cast<std::ptrdiff_t>(b.start));
+                a = Entry{b.lo, b.hi, a.start};
+            } else {
+                a = Entry{std::max(a.lo, b.lo), std::max(a.hi, b.hi) + 0.25f * k, a.start};
+                outTape.push_back(instruction);
+            }
+        } else {
+            // max(a, -b) is a once a >= -b + k. The other way round would leave -b, which has no instruction
+            if (a.lo + b.lo >= k) {
+                outTape.resize(b.start);
+            } else {
+                a = Entry{std::max(a.lo, -b.hi), std::max(a.hi, -b.lo) + 0.25f * k, a.start};
+                outTape.push_back(instruction);
+            }
+        }
+    }
+}
+
+SDFEvaluator::PruneCheck SDFEvaluator::checkPrunedCSG(const std::vector<CSGInstruction>& tape, const std::vector<CSGInstruction>& prunedTape,
+                                                      const vec3& boxMin, const vec3& boxMax, int samplesPerAxis) const {
+    PruneCheck check;
+    const int n = std::max(samplesPerAxis, 1);
+    for (int z = 0; z < n; ++z) {
+        for (int y = 0; y < n; ++y) {
+            for (int x = 0; x < n; ++x) {
+                // Cell centers, so every point is strictly inside the box
+                const vec3 t = (vec3(static_cast<float>(x), static_cast<float>(y), static_cast<float>(z)) + 0.5f) / static_cast<float>(n);
+                const vec3 p = mix(boxMin, boxMax, t);
+                vec3 fullGradient, prunedGradient;
+                const SDFSample full = evaluateCSG(tape, p, &fullGradient);
+                const SDFSample pruned = evaluateCSG(prunedTape, p, &prunedGradient);
+                check.maxDistError = std::max(check.maxDistError, std::abs(full.dist - pruned.dist));
+                check.maxGradientError = std::max(check.maxGradientError, length(fullGradient - prunedGradient));
+                check.maxColorError = std::max(check.maxColorError, length(full.color - pruned.color));
+                if (full.objectIndex != pruned.objectIndex) ++check.indexMismatches;
+                ++check.samples;
+            }
+        }
+    }
+    return check;
+}
+
+SDFSample SDFEvaluator::evaluate(const vec3& p) const {
+    if (!m_csgProgram.empty()) return evaluateCSG(m_csgProgram, p, nullptr);
+    return evaluateBlend(p, nullptr);
+}
+
+SDFSample SDFEvaluator::evaluateWithGradient(const vec3& p, vec3& outGradient) const {
+    if (!m_csgProgram.empty()) return evaluateCSG(m_csgProgram, p, &outGradient);
+    return evaluateBlend(p, &outGradient);
+}
+
+SDFSample SDFEvaluator::evaluateBlend(const vec3& p, vec3* outGradient) const {
+    SDFSample res;
+    res.dist = sdfkernels::MAX_DIST;
+    res.color = m_clearColor;
+    res.objectIndex = -1;
+    if (outGradient) *outGradient = vec3(0.0f);
+
+    const float k = m_blendSmoothness;
+    const float blendRadius = k * sdfkernels::BLEND_RADIUS_SCALE;
+    BlendGroup group;
+
+    for (int i = 0; i < static_cast<int>(m_objects.size()); ++i) {
+        const SDFObjectGPUData& obj = m_objects[i];
+        // Bounding sphere early out, same as blendObject
+        if (length(p - obj.position) - getBoundingRadius(obj) > std::min(res.dist, group.nearest) + blendRadius) continue;
+
+        vec3 gradient = vec3(0.0f);
+        SDFSample object = evaluateObject(i, p, outGradient ? &gradient : nullptr);
+        blendDistance(res, outGradient, group, i, getBlendGroup(obj), object.dist, gradient, object.color, k);
+    }
+    closeBlendGroup(res, outGradient, group, k);
+    return res;
+}
+
+void SDFEvaluator::evaluateBatch(const vec3* points, int count, float* outDist,
+                                 int* outIndex, vec3* outColor) const {
+    if (count <= 0) return;
+
+    // Empty scenes, CSG programs (the kernels only know the smin chain) and CPUs without AVX2 go through the reference path
+    if (m_objects.empty() || !m_csgProgram.empty() || m_isa == ISA::SCALAR) {
+        for (int i = 0; i < count; ++i) {
+            SDFSample s = evaluate(points[i]);
+            outDist[i] = s.dist;
+            if (outIndex) outIndex[i] = s.objectIndex;
+            if (outColor) outColor[i] = s.color;
+        }
+        return;
+    }
+
+    const int width = (m_isa == ISA::AVX512) ? sdfkernels::AVX512_WIDTH : sdfkernels::AVX2_WIDTH;
+    alignas(64) float xs[sdfkernels::AVX512_WIDTH], ys[sdfkernels::AVX512_WIDTH], zs[sdfkernels::AVX512_WIDTH];
+    alignas(64) float dist[sdfkernels::AVX512_WIDTH];
+    alignas(64) float r[sdfkernels::AVX512_WIDTH], g[sdfkernels::AVX512_WIDTH], b[sdfkernels::AVX512_WIDTH];
+    int index[sdfkernels::AVX512_WIDTH];
+
+    sdfkernels::Batch batch{xs, ys, zs, dist,
+                            outColor ? r : nullptr, outColor ? g : nullptr, outColor ? b : nullptr,
+                            outIndex ? index : nullptr};
+
+    for (int start = 0; start < count; start += width) {
+        int n = std::min(width, count - start);
+        // Pad the tail with the last point so every lane holds valid data
+        for (int lane = 0; lane < width; ++lane) {
+            const vec3& p = points[start + std::min(lane, n - 1)];
+            xs[lane] = p.x; ys[lane] = p.y; zs[lane] = p.z;
+        }
+
+        if (m_isa == ISA::AVX512) {
+            sdfkernels::evaluateAVX512(m_prepared.data(), static_cast<int>(m_prepared.size()), m_blendSmoothness, batch);
+        } else {
+            sdfkernels::evaluateAVX2(m_prepared.data(), static_cast<int>(m_prepared.size()), m_blendSmoothness, batch);
+        }
+
+        for (int lane = 0; lane < n; ++lane) {
+            outDist[start + lane] = dist[lane];
+            if (outIndex) outIndex[start + lane] = index[lane];
+            if (outColor) outColor[start + lane] = vec3(r[lane], g[lane], b[lane]);
+        }
+    }
+}
+
+void SDFEvaluator::setISA(ISA isa) {
+    ISA supported = detectISA();
+    m_isa = (static_cast<int>(isa) <= static_cast<int>(supported)) ? isa : supported;
+}
+
+SDFEvaluator::ISA SDFEvaluator::detectISA() {
+#if defined(ASTRAL_SIMD_X86)
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return ISA::AVX512;
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return ISA::AVX2;
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    int maxLeaf = info[0];
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool fma = (info[2] & (1 << 12)) != 0;
+    if (osxsave && maxLeaf >= 7) {
+        unsigned long long xcr0 = _xgetbv(0);
+        bool ymmEnabled = (xcr0 & 0x6) == 0x6;
+        bool zmmEnabled = (xcr0 & 0xe6) == 0xe6;
+        __cpuidex(info, 7, 0);
+        if (zmmEnabled && (info[1] & (1 << 16))) return ISA::AVX512;
+        if (ymmEnabled && fma && (info[1] & (1 << 5))) return ISA::AVX2;
+    }
+#endif
+#endif
+    return ISA::SCALAR;
+}
+
+const char* SDFEvaluator::getISAName(ISA isa) {
+    switch (isa) {
+        case ISA::AVX512: return "AVX-512";
+        case ISA::AVX2:   return "AVX2";
+        default:          return "Scalar";
+    }
+}
@@ -0,0 +1,91 @@
+//
+// CPU reference evaluator of the scene distance function (mapTheWorld in raymarch.frag).
+// Reads the same SDFObjectGPUData array the renderer uploads, so no GL context is needed.
+//
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+#include "Basic/SDFObject.h"
+#include "Basic/SDFEvaluatorKernels.h"
+#include "Basic/CSGTree.h"
+
+// Same fields as SDFResult in raymarch.frag (isSelected is left to the caller)
+struct SDFSample {
+    float dist = sdfkernels::MAX_DIST;
+    glm::vec3 color = glm::vec3(0.0f);
+    int objectIndex = -1;
+};
+
+class SDFEvaluator {
+public:
+    enum class ISA { SCALAR, AVX2, AVX512 };
+
+    SDFEvaluator();
+
+    // Load the scene, same layout as the GPU object buffer
+    void setObjects(const std::vector<SDFObjectGPUData>& objects);
+    void setBlendSmoothness(float k) { m_blendSmoothness = k; }
+    void setClearColor(const glm::vec3& color) { m_clearColor = color; }
+    // Scene composition from CSGTree::compile, empty = the plain smooth union of every object
+    void setCSGProgram(const std::vector<CSGInstruction>& program) { m_csgProgram = program; }
+    bool hasCSGProgram() const { return !m_csgProgram.empty(); }
+    const std::vector<CSGInstruction>& getCSGProgram() const { return m_csgProgram; }
+
+    // Interval pass over the axis-aligned box (tape pruning as in Keeter's "Massively Parallel Rendering of
+    // Complex Closed-Form Implicit Surfaces"): bounds every exact object's distance over the box (the others are
+    // left unbounded), then copies into outTape only the instructions of 'tape' that can change the result there. Inside the box the pruned tape
+    // gives the same distance, gradient, color and index. 'tape' is the program or a larger box's pruned tape
+    void pruneCSG(const std::vector<CSGInstruction>& tape, const glm::vec3& boxMin, const glm::vec3& boxMax,
+                  std::vector<CSGInstruction>& outTape) const;
+
+    // Largest differences between running 'tape' and 'prunedTape' at a grid of samplesPerAxis^3 points inside the
+    // box. pruneCSG promises they are all zero up to float rounding
+    struct PruneCheck {
+        float maxDistError = 0.0f;
+        float maxGradientError = 0.0f;
+        float maxColorError = 0.0f;
+        int indexMismatches = 0;
+        int samples = 0;
+    };
+    PruneCheck checkPrunedCSG(const std::vector<CSGInstruction>& tape, const std::vector<CSGInstruction>& prunedTape,
+                              const glm::vec3& boxMin, const glm::vec3& boxMax, int samplesPerAxis = 6) const;
+
+    int getObjectCount() const { return static_cast<int>(m_objects.size()); }
+    float getBlendSmoothness() const { return m_blendSmoothness; }
+    // Largest per-object Lipschitz bound (color.w), what the shader's SDFResult.lipschitz is without culling
+    float getLipschitzBound() const { return m_lipschitz; }
+
+    // Scalar path, follows the shader line by line. Objects must be sorted by blend group
+    SDFSample evaluate(const glm::vec3& p) const;
+    // Scalar path with the analytic world space gradient (mapScene(p, true) in the shader)
+    SDFSample evaluateWithGradient(const glm::vec3& p, glm::vec3& outGradient) const;
+
+    // Evaluates count points in batches of 8 (AVX2) or 16 (AVX-512), or one by one with a CSG program.
+    // outIndex and outColor may be null
+    void evaluateBatch(const glm::vec3* points, int count, float* outDist,
+                       int* outIndex = nullptr, glm::vec3* outColor = nullptr) const;
+
+    // Instruction set used by evaluateBatch, picked at startup from the running CPU
+    ISA getISA() const { return m_isa; }
+    // Force a narrower path (for validation), clamped to what the CPU supports
+    void setISA(ISA isa);
+
+    static ISA detectISA();
+    static const char* getISAName(ISA isa);
+
+private:
+    // Object i on its own (evaluateObject in the shader), the gradient only when outGradient is set
+    SDFSample evaluateObject(int i, const glm::vec3& p, glm::vec3* outGradient) const;
+    // Plain blend of every object (the culled loop of mapScene in the shader)
+    SDFSample evaluateBlend(const glm::vec3& p, glm::vec3* outGradient) const;
+    // Runs a postfix program, m_csgProgram or a pruned tape (runCSG in the shader)
+    SDFSample evaluateCSG(const std::vector<CSGInstruction>& program, const glm::vec3& p, glm::vec3* outGradient) const;
+
+    std::vector<SDFObjectGPUData> m_objects;
+    std::vector<CSGInstruction> m_csgProgram;
+    std::vector<sdfkernels::PreparedObject> m_prepared;
+    float m_blendSmoothness = 0.1f;
+    float m_lipschitz = 1.0f;
+    glm::vec3 m_clearColor = glm::vec3(0.0f);
+    ISA m_isa = ISA::SCALAR;
+};
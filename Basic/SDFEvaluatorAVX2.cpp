@@ -0,0 +1,52 @@
+//
+// AVX2 + FMA kernel for SDFEvaluator (8 points per call). Built with -mavx2 -mfma, only called after a runtime check.
+//
+
+#include "SDFEvaluatorKernels.h"
+
+#if defined(ASTRAL_SIMD_X86)
+#include <immintrin.h>
+
+namespace {
+    struct AVX2Lanes {
+        using F = __m256;
+        using M = __m256;
+        static constexpr int WIDTH = sdfkernels::AVX2_WIDTH;
+
+        static F load(const float* p) { return _mm256_loadu_ps(p); }
+        static void store(float* p, F a) { _mm256_storeu_ps(p, a); }
+        static F set1(float v) { return _mm256_set1_ps(v); }
+        static F add(F a, F b) { return _mm256_add_ps(a, b); }
+        static F sub(F a, F b) { return _mm256_sub_ps(a, b); }
+        static F mul(F a, F b) { return _mm256_mul_ps(a, b); }
+        static F div(F a, F b) { return _mm256_div_ps(a, b); }
+        static F fmadd(F a, F b, F c) { return _mm256_fmadd_ps(a, b, c); }
+        static F min(F a, F b) { return _mm256_min_ps(a, b); }
+        static F max(F a, F b) { return _mm256_max_ps(a, b); }
+        static F sqrt(F a) { return _mm256_sqrt_ps(a); }
+        static F abs(F a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+        static M lt(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+        static M gt(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+        // Lanes where mask is set take a, the rest take b
+        static F select(M mask, F a, F b) { return _mm256_blendv_ps(b, a, mask); }
+        static bool all(M mask) { return _mm256_movemask_ps(mask) == 0xFF; }
+        static F floor(F a) { return _mm256_floor_ps(a); }
+        // 2^n for integer valued n in [-126, 127]
+        static F pow2(F n) { return _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127)), 23)); }
+        // a = mantissa * 2^exponent with the mantissa in [1, 2), for positive normal a
+        static F exponent(F a) { return _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(_mm256_castps_si256(a), 23), _mm256_set1_epi32(127))); }
+        static F mantissa(F a) { return _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(_mm256_castps_si256(a), _mm256_set1_epi32(0x007FFFFF)), _mm256_set1_epi32(0x3F800000))); }
+    };
+
+#include "SDFEvaluatorSIMD.inl"
+}
+
+void sdfkernels::evaluateAVX2(const PreparedObject* objects, int count, float blendK, const Batch& batch) {
+    evaluateLanes<AVX2Lanes>(objects, count, blendK, batch);
+}
+
+#else
+
+void sdfkernels::evaluateAVX2(const PreparedObject*, int, float, const Batch&) {}
+
+#endif
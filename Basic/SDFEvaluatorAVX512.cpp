@@ -0,0 +1,52 @@
+//
+// AVX-512F kernel for SDFEvaluator (16 points per call). Built with -mavx512f, only called after a runtime check.
+//
+
+#include "SDFEvaluatorKernels.h"
+
+#if defined(ASTRAL_SIMD_X86)
+#include <immintrin.h>
+
+namespace {
+    struct AVX512Lanes {
+        using F = __m512;
+        using M = __mmask16;
+        static constexpr int WIDTH = sdfkernels::AVX512_WIDTH;
+
+        static F load(const float* p) { return _mm512_loadu_ps(p); }
+        static void store(float* p, F a) { _mm512_storeu_ps(p, a); }
+        static F set1(float v) { return _mm512_set1_ps(v); }
+        static F add(F a, F b) { return _mm512_add_ps(a, b); }
+        static F sub(F a, F b) { return _mm512_sub_ps(a, b); }
+        static F mul(F a, F b) { return _mm512_mul_ps(a, b); }
+        static F div(F a, F b) { return _mm512_div_ps(a, b); }
+        static F fmadd(F a, F b, F c) { return _mm512_fmadd_ps(a, b, c); }
+        static F min(F a, F b) { return _mm512_min_ps(a, b); }
+        static F max(F a, F b) { return _mm512_max_ps(a, b); }
+        static F sqrt(F a) { return _mm512_sqrt_ps(a); }
+        static F abs(F a) { return _mm512_castsi512_ps(_mm512_and_epi32(_mm512_castps_si512(a), _mm512_set1_epi32(0x7fffffff))); }
+        static M lt(F a, F b) { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+        static M gt(F a, F b) { return _mm512_cmp_ps_mask(a, b, _CMP_GT_OQ); }
+        // Lanes where mask is set take a, the rest take b
+        static F select(M mask, F a, F b) { return _mm512_mask_blend_ps(mask, b, a); }
+        static bool all(M mask) { return mask == 0xFFFF; }
+        static F floor(F a) { return _mm512_roundscale_ps(a, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC); }
+        // 2^n for integer valued n in [-126, 127]
+        static F pow2(F n) { return _mm512_castsi512_ps(_mm512_slli_epi32(_mm512_add_epi32(_mm512_cvtps_epi32(n), _mm512_set1_epi32(127)), 23)); }
+        // a = mantissa * 2^exponent with the mantissa in [1, 2), for positive normal a
+        static F exponent(F a) { return _mm512_cvtepi32_ps(_mm512_sub_epi32(_mm512_srli_epi32(_mm512_castps_si512(a), 23), _mm512_set1_epi32(127))); }
+        static F mantissa(F a) { return _mm512_castsi512_ps(_mm512_or_epi32(_mm512_and_epi32(_mm512_castps_si512(a), _mm512_set1_epi32(0x007FFFFF)), _mm512_set1_epi32(0x3F800000))); }
+    };
+
+#include "SDFEvaluatorSIMD.inl"
+}
+
+void sdfkernels::evaluateAVX512(const PreparedObject* objects, int count, float blendK, const Batch& batch) {
+    evaluateLanes<AVX512Lanes>(objects, count, blendK, batch);
+}
+
+#else
+
+void sdfkernels::evaluateAVX512(const PreparedObject*, int, float, const Batch&) {}
+
+#endif
@@ -0,0 +1,52 @@
+//
+// Plain data shared between SDFEvaluator and its SIMD kernels.
+// The kernel translation units are compiled with AVX2 / AVX-512 flags, so this header
+// must stay free of glm and other inline code that could leak wide instructions into the scalar build.
+//
+#pragma once
+#include "Basic/SDFType.h"
+
+namespace sdfkernels {
+
+    // Must match the constants in raymarch.frag
+    constexpr float MAX_DIST = 100.0f;
+
+    // Order independent smooth union (BlendGroup in raymarch.frag): exponential smin with ke = k * BLEND_EXP_SCALE,
+    // so an object BLEND_RADIUS_SCALE * k beyond the nearest one weighs 2^-24 and culling it changes nothing
+    constexpr float BLEND_EXP_SCALE = 0.36067376f; // 1 / (4 ln 2)
+    constexpr float BLEND_RADIUS_SCALE = 6.0f;
+    constexpr float BLEND_MIN_K = 1e-6f;
+
+    // One object of the scene, flattened for broadcasting into SIMD lanes
+    struct PreparedObject {
+        float rows[3][4];    // First three rows of the inverse model matrix, rebuilt from the quaternion
+        float params[3];     // SDFObject::parameters, the inner box for ROUNDED_BOX
+        float invParams[3];  // 1 / max(radii, 1e-6)  (ellipsoid only)
+        float invParamsSq[3];// 1 / max(radii, 1e-6)^2 (ellipsoid only)
+        float paramsLength;  // length(max(radii, 1e-6)) (ellipsoid only)
+        float radius;        // Corner radius (rounded box only)
+        float color[3];
+        int type;            // SDFType as int, objects come in runs of one type
+        int blendGroup;
+        float sphere[4];     // Bounding sphere: world center, radius
+    };
+
+    // Structure-of-arrays view of one batch of points; outputs other than dist may be null
+    struct Batch {
+        const float* x;
+        const float* y;
+        const float* z;
+        float* dist;
+        float* r;
+        float* g;
+        float* b;
+        int* index;
+    };
+
+    // Each kernel evaluates exactly its lane width worth of points
+    constexpr int AVX2_WIDTH = 8;
+    constexpr int AVX512_WIDTH = 16;
+
+    void evaluateAVX2(const PreparedObject* objects, int count, float blendK, const Batch& batch);
+    void evaluateAVX512(const PreparedObject* objects, int count, float blendK, const Batch& batch);
+}
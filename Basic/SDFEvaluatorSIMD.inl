@@ -0,0 +1,239 @@
+//
+// Lane-generic body of mapTheWorld, included by the AVX2 and AVX-512 kernel files.
+// V supplies the vector type F, the mask type M and the handful of ops used below.
+// Included inside an anonymous namespace, so every kernel file gets its own copy compiled with its own flags.
+//
+
+// e^t for t <= 0 (the smin weights): 2^n * 2^f with t * log2(e) = n + f, f in [-0.5, 0.5] and 2^f from its series
+template <class V>
+typename V::F expNonPositive(typename V::F t) {
+    using F = typename V::F;
+    F x = V::max(V::mul(t, V::set1(1.44269504f)), V::set1(-126.0f));
+    F n = V::floor(V::add(x, V::set1(0.5f)));
+    F f = V::sub(x, n);
+    F p = V::set1(1.5252734e-5f); // ln(2)^i / i!
+    p = V::fmadd(p, f, V::set1(1.5403530e-4f));
+    p = V::fmadd(p, f, V::set1(1.3333558e-3f));
+    p = V::fmadd(p, f, V::set1(9.6181291e-3f));
+    p = V::fmadd(p, f, V::set1(5.5504109e-2f));
+    p = V::fmadd(p, f, V::set1(2.4022651e-1f));
+    p = V::fmadd(p, f, V::set1(6.9314718e-1f));
+    p = V::fmadd(p, f, V::set1(1.0f));
+    return V::mul(p, V::pow2(n));
+}
+
+// ln(x) for x >= 1 (the weight sums): exponent * ln(2) + ln(mantissa), the mantissa moved into
+// [sqrt(1/2), sqrt(2)] and its log from the series 2 * atanh(z), z = (m - 1) / (m + 1)
+template <class V>
+typename V::F logAtLeastOne(typename V::F x) {
+    using F = typename V::F;
+    using M = typename V::M;
+    const F one = V::set1(1.0f);
+    F e = V::exponent(x);
+    F m = V::mantissa(x);
+    M high = V::gt(m, V::set1(1.41421356f));
+    m = V::select(high, V::mul(m, V::set1(0.5f)), m);
+    e = V::select(high, V::add(e, one), e);
+    F z = V::div(V::sub(m, one), V::add(m, one));
+    F z2 = V::mul(z, z);
+    F series = V::set1(1.0f / 9.0f);
+    series = V::fmadd(series, z2, V::set1(1.0f / 7.0f));
+    series = V::fmadd(series, z2, V::set1(1.0f / 5.0f));
+    series = V::fmadd(series, z2, V::set1(1.0f / 3.0f));
+    series = V::fmadd(series, z2, one);
+    return V::fmadd(e, V::set1(0.69314718f), V::mul(V::add(z, z), series));
+}
+
+// Local space distance of one primitive type, the lane version of its SDFPrimitives function
+template <class V, SDFType TYPE>
+typename V::F primitiveLanes(const sdfkernels::PreparedObject& obj, typename V::F lx, typename V::F ly, typename V::F lz) {
+    using F = typename V::F;
+    const F zero = V::set1(0.0f);
+    const F one = V::set1(1.0f);
+    if constexpr (TYPE == SDFType::SPHERE) {
+        // sdEllipsoidLocal
+        F ax = V::mul(lx, V::set1(obj.invParams[0]));
+        F ay = V::mul(ly, V::set1(obj.invParams[1]));
+        F az = V::mul(lz, V::set1(obj.invParams[2]));
+        F k0 = V::sqrt(V::fmadd(ax, ax, V::fmadd(ay, ay, V::mul(az, az))));
+        F bx = V::mul(lx, V::set1(obj.invParamsSq[0]));
+        F by = V::mul(ly, V::set1(obj.invParamsSq[1]));
+        F bz = V::mul(lz, V::set1(obj.invParamsSq[2]));
+        F k1 = V::sqrt(V::fmadd(bx, bx, V::fmadd(by, by, V::mul(bz, bz))));
+        F bound = V::div(V::mul(k0, V::sub(k0, one)), k1);
+        F nearCenter = V::sub(V::sqrt(V::fmadd(lx, lx, V::fmadd(ly, ly, V::mul(lz, lz)))), V::set1(obj.paramsLength));
+        return V::select(V::lt(k1, V::set1(1e-7f)), nearCenter, bound);
+    } else if constexpr (TYPE == SDFType::BOX || TYPE == SDFType::ROUNDED_BOX) {
+        // sdBoxLocal, the rounded box is its inner box minus the corner radius
+        F qx = V::sub(V::abs(lx), V::set1(obj.params[0]));
+        F qy = V::sub(V::abs(ly), V::set1(obj.params[1]));
+        F qz = V::sub(V::abs(lz), V::set1(obj.params[2]));
+        F ox = V::max(qx, zero), oy = V::max(qy, zero), oz = V::max(qz, zero);
+        F outside = V::sqrt(V::fmadd(ox, ox, V::fmadd(oy, oy, V::mul(oz, oz))));
+        F inside = V::min(V::max(qx, V::max(qy, qz)), zero);
+        F d = V::add(outside, inside);
+        if constexpr (TYPE == SDFType::ROUNDED_BOX) d = V::sub(d, V::set1(obj.radius));
+        return d;
+    } else if constexpr (TYPE == SDFType::TORUS) {
+        F qx = V::sub(V::sqrt(V::fmadd(lx, lx, V::mul(ly, ly))), V::set1(obj.params[0]));
+        return V::sub(V::sqrt(V::fmadd(qx, qx, V::mul(lz, lz))), V::set1(obj.params[1]));
+    } else if constexpr (TYPE == SDFType::CAPSULE) {
+        const F halfLength = V::set1(obj.params[1]);
+        F cz = V::sub(lz, V::min(V::max(lz, V::sub(zero, halfLength)), halfLength));
+        return V::sub(V::sqrt(V::fmadd(lx, lx, V::fmadd(ly, ly, V::mul(cz, cz)))), V::set1(obj.params[0]));
+    } else if constexpr (TYPE == SDFType::CYLINDER) {
+        F dx = V::sub(V::sqrt(V::fmadd(lx, lx, V::mul(ly, ly))), V::set1(obj.params[0]));
+        F dz = V::sub(V::abs(lz), V::set1(obj.params[1]));
+        F ox = V::max(dx, zero), oz = V::max(dz, zero);
+        return V::add(V::min(V::max(dx, dz), zero), V::sqrt(V::fmadd(ox, ox, V::mul(oz, oz))));
+    } else if constexpr (TYPE == SDFType::CONE) {
+        // sdConeLocal with the apex (0, h) and slant (-r, 2h) folded into scalars
+        const float r = obj.params[0];
+        const float h = obj.params[1];
+        const float invSlantSq = 1.0f / (r * r + 4.0f * h * h);
+        F qx = V::sqrt(V::fmadd(lx, lx, V::mul(ly, ly)));
+        F capRadius = V::select(V::lt(lz, zero), V::set1(r), zero);
+        F cax = V::sub(qx, V::min(qx, capRadius));
+        F cay = V::sub(V::abs(lz), V::set1(h));
+        F t = V::mul(V::fmadd(qx, V::set1(r), V::mul(V::sub(V::set1(h), lz), V::set1(2.0f * h))), V::set1(invSlantSq));
+        t = V::min(V::max(t, zero), one);
+        F cbx = V::sub(qx, V::mul(V::set1(r), t));
+        F cby = V::add(V::sub(lz, V::set1(h)), V::mul(V::set1(2.0f * h), t));
+        F d = V::sqrt(V::min(V::fmadd(cax, cax, V::mul(cay, cay)), V::fmadd(cbx, cbx, V::mul(cby, cby))));
+        return V::select(V::lt(V::max(cbx, cay), zero), V::sub(zero, d), d);
+    } else if constexpr (TYPE == SDFType::PLANE) {
+        F qx = V::max(V::sub(V::abs(lx), V::set1(obj.params[0])), zero);
+        F qy = V::max(V::sub(V::abs(ly), V::set1(obj.params[1])), zero);
+        return V::sqrt(V::fmadd(qx, qx, V::fmadd(qy, qy, V::mul(lz, lz))));
+    } else {
+        return V::set1(sdfkernels::MAX_DIST);
+    }
+}
+
+// Blend result of the lanes: the closed blend groups (hard min of their results) and the open one
+// (BlendGroup in raymarch.frag), whose sums are relative to its nearest object
+template <class V>
+struct LaneBlend {
+    using F = typename V::F;
+    using M = typename V::M;
+
+    F x, y, z;
+    F keLanes, negInvKe, blendRadius;
+
+    F resDist = V::set1(sdfkernels::MAX_DIST);
+    F resR = V::set1(0.0f), resG = V::set1(0.0f), resB = V::set1(0.0f);
+    F resIndex = V::set1(-1.0f);
+
+    int groupId = -1;
+    F nearest = V::set1(sdfkernels::MAX_DIST);
+    F weightSum = V::set1(0.0f);
+    F sumR = V::set1(0.0f), sumG = V::set1(0.0f), sumB = V::set1(0.0f);
+    F groupIndex = V::set1(-1.0f);
+
+    void closeGroup() {
+        const F one = V::set1(1.0f);
+        F dist = V::sub(nearest, V::mul(keLanes, logAtLeastOne<V>(V::max(weightSum, one))));
+        dist = V::select(V::gt(groupIndex, V::set1(-0.5f)), dist, V::set1(1e30f)); // Lanes without an object lose the min
+        M wins = V::lt(dist, resDist);
+        F invWeightSum = V::div(one, V::max(weightSum, one));
+        resDist = V::select(wins, dist, resDist);
+        resR = V::select(wins, V::mul(sumR, invWeightSum), resR);
+        resG = V::select(wins, V::mul(sumG, invWeightSum), resG);
+        resB = V::select(wins, V::mul(sumB, invWeightSum), resB);
+        resIndex = V::select(wins, groupIndex, resIndex);
+        nearest = V::set1(sdfkernels::MAX_DIST);
+        weightSum = V::set1(0.0f);
+        sumR = V::set1(0.0f); sumG = V::set1(0.0f); sumB = V::set1(0.0f);
+        groupIndex = V::set1(-1.0f);
+    }
+
+    // Objects [begin, end), all of primitive type TYPE: the type is fixed for the whole loop
+    template <SDFType TYPE>
+    void blendRange(const sdfkernels::PreparedObject* objects, int begin, int end) {
+        const F zero = V::set1(0.0f);
+        const F one = V::set1(1.0f);
+        for (int i = begin; i < end; ++i) {
+            const sdfkernels::PreparedObject& obj = objects[i];
+            if (obj.blendGroup != groupId) {
+                closeGroup();
+                groupId = obj.blendGroup;
+            }
+
+            // Bounding sphere early out (blendObject in the shader): lanes where the sphere is more than the blend radius
+            // beyond the nearest object add nothing, and the object is skipped when that holds for every lane
+            F sx = V::sub(x, V::set1(obj.sphere[0]));
+            F sy = V::sub(y, V::set1(obj.sphere[1]));
+            F sz = V::sub(z, V::set1(obj.sphere[2]));
+            F sphereDist = V::sub(V::sqrt(V::fmadd(sx, sx, V::fmadd(sy, sy, V::mul(sz, sz)))), V::set1(obj.sphere[3]));
+            M skip = V::gt(sphereDist, V::add(V::min(resDist, nearest), blendRadius));
+            if (V::all(skip)) continue;
+
+            // Point in object local space
+            F lx = V::fmadd(x, V::set1(obj.rows[0][0]), V::fmadd(y, V::set1(obj.rows[0][1]), V::fmadd(z, V::set1(obj.rows[0][2]), V::set1(obj.rows[0][3]))));
+            F ly = V::fmadd(x, V::set1(obj.rows[1][0]), V::fmadd(y, V::set1(obj.rows[1][1]), V::fmadd(z, V::set1(obj.rows[1][2]), V::set1(obj.rows[1][3]))));
+            F lz = V::fmadd(x, V::set1(obj.rows[2][0]), V::fmadd(y, V::set1(obj.rows[2][1]), V::fmadd(z, V::set1(obj.rows[2][2]), V::set1(obj.rows[2][3]))));
+            F d = primitiveLanes<V, TYPE>(obj, lx, ly, lz);
+
+            const F objR = V::set1(obj.color[0]);
+            const F objG = V::set1(obj.color[1]);
+            const F objB = V::set1(obj.color[2]);
+            const F objIndex = V::set1(static_cast<float>(i));
+
+            // One exp per lane: a new nearest object rescales the sums by it, any other object is added with it as weight.
+            // Skipped lanes add a zero weight
+            M nearer = V::lt(V::select(skip, V::set1(1e30f), d), nearest);
+            F weight = expNonPositive<V>(V::mul(V::abs(V::sub(d, nearest)), negInvKe));
+            weight = V::select(skip, zero, weight);
+            weightSum = V::select(nearer, V::fmadd(weightSum, weight, one), V::add(weightSum, weight));
+            sumR = V::select(nearer, V::fmadd(sumR, weight, objR), V::fmadd(weight, objR, sumR));
+            sumG = V::select(nearer, V::fmadd(sumG, weight, objG), V::fmadd(weight, objG, sumG));
+            sumB = V::select(nearer, V::fmadd(sumB, weight, objB), V::fmadd(weight, objB, sumB));
+            groupIndex = V::select(nearer, objIndex, groupIndex);
+            nearest = V::select(nearer, d, nearest);
+        }
+    }
+};
+
+template <class V>
+void evaluateLanes(const sdfkernels::PreparedObject* objects, int count, float blendK, const sdfkernels::Batch& batch) {
+    LaneBlend<V> blend;
+    blend.x = V::load(batch.x);
+    blend.y = V::load(batch.y);
+    blend.z = V::load(batch.z);
+    const float ke = (blendK > sdfkernels::BLEND_MIN_K ? blendK : sdfkernels::BLEND_MIN_K) * sdfkernels::BLEND_EXP_SCALE;
+    blend.keLanes = V::set1(ke);
+    blend.negInvKe = V::set1(-1.0f / ke);
+    blend.blendRadius = V::set1(blendK * sdfkernels::BLEND_RADIUS_SCALE);
+
+    // The objects come sorted into runs of one primitive type, each run gets the loop specialized for its type
+    for (int begin = 0; begin < count;) {
+        const int type = objects[begin].type;
+        int end = begin + 1;
+        while (end < count && objects[end].type == type) ++end;
+        switch (static_cast<SDFType>(type)) {
+            case SDFType::SPHERE: blend.template blendRange<SDFType::SPHERE>(objects, begin, end); break;
+            case SDFType::BOX: blend.template blendRange<SDFType::BOX>(objects, begin, end); break;
+            case SDFType::TORUS: blend.template blendRange<SDFType::TORUS>(objects, begin, end); break;
+            case SDFType::CAPSULE: blend.template blendRange<SDFType::CAPSULE>(objects, begin, end); break;
+            case SDFType::CYLINDER: blend.template blendRange<SDFType::CYLINDER>(objects, begin, end); break;
+            case SDFType::CONE: blend.template blendRange<SDFType::CONE>(objects, begin, end); break;
+            case SDFType::PLANE: blend.template blendRange<SDFType::PLANE>(objects, begin, end); break;
+            case SDFType::ROUNDED_BOX: blend.template blendRange<SDFType::ROUNDED_BOX>(objects, begin, end); break;
+            default: blend.template blendRange<SDFType::COUNT>(objects, begin, end); break; // Unknown, never hit
+        }
+        begin = end;
+    }
+    blend.closeGroup();
+
+    V::store(batch.dist, blend.resDist);
+    if (batch.r) V::store(batch.r, blend.resR);
+    if (batch.g) V::store(batch.g, blend.resG);
+    if (batch.b) V::store(batch.b, blend.resB);
+    if (batch.index) {
+        alignas(64) float indices[V::WIDTH];
+        V::store(indices, blend.resIndex);
+        for (int lane = 0; lane < V::WIDTH; ++lane) {
+            batch.index[lane] = static_cast<int>(indices[lane]);
+        }
+    }
+}
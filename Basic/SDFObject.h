@@ -5,14 +5,16 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/packing.hpp>
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
 #include <string>
 #include <vector>
+#include "Basic/SDFPrimitives.h"
 
-enum class SDFType : int {
-    SPHERE = 0, // Sphere and ellipsoids now
-    BOX = 1
-    // Other SDF here (make them be added dynamically)
-};
+struct SDFObjectGPUData;
 
 struct SDFObject {
     int id; // ID each selection
@@ -23,7 +25,13 @@ struct SDFObject {
     glm::vec3 rotation = glm::vec3(0.0f); // Euler angles for simplicity
 
     glm::vec3 color = glm::vec3(1.0f);
-    glm::vec3 parameters = glm::vec3(0.5f); // Default size or half-size
+    glm::vec3 parameters = glm::vec3(0.5f); // Meaning per type, see SDFType
+    float rounding = 0.25f; // ROUNDED_BOX: corner radius as a fraction of the smallest half size (0-1)
+    int blendGroup = 0; // Objects blend smoothly within their group, groups combine with a hard min (0-255)
+
+    // Set whenever something the GPU sees changed (transform, color, parameters, rounding, type, blend group).
+    // Cleared by SDFObjectBuffer once the object has been re-uploaded.
+    bool gpuDirty = true;
 
     // Helper functions
     glm::mat4 getModelMatrix() const {
@@ -35,19 +43,31 @@ struct SDFObject {
         return model;
     }
 
-    glm::mat4 getInverseModelMatrix() const {
-        return inverse(getModelMatrix());
+    // How much the distance function can overestimate the true distance (1 = exact).
+    // Every primitive but the ellipsoid is exact. The ellipsoid bound never overestimates outside, but inside it
+    // does by up to ~2.6x for elongated shapes (measured), so it grows with the ratio of the radii
+    float getLipschitzBound() const {
+        if (SDFPrimitives::get(type).exact) return 1.0f;
+        glm::vec3 radii = glm::max(parameters, glm::vec3(1e-6f));
+        float ratio = glm::max(radii.x, glm::max(radii.y, radii.z)) / glm::min(radii.x, glm::min(radii.y, radii.z));
+        return glm::min(1.0f + 0.4f * (ratio - 1.0f), 3.0f);
     }
 
+    // Call after editing position, rotation, color, parameters, rounding, type or blend group
+    void markDirty() {
+        gpuDirty = true;
+    }
+
+    // Layout sent to the GPU (and read by the CPU evaluator)
+    SDFObjectGPUData toGPUData() const;
+
     // Constructor
     SDFObject(int uniqueId, SDFType t = SDFType::SPHERE) : id(uniqueId), type(t) {
-        std::string typeName = (type == SDFType::BOX) ? "box" : "sphere"; // Generate the default name based on type and ID
+        const SDFPrimitive& primitive = SDFPrimitives::get(type);
+        std::string typeName = primitive.name; // Generate the default name based on type and ID
+        for (char& c : typeName) c = (c == ' ') ? '_' : static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
         name = typeName + "_" +std::to_string(uniqueId);
-        if (type == SDFType::SPHERE) {
-            parameters = glm::vec3(0.5f);
-        } else {
-            parameters = glm::vec3(0.5f);
-        }
+        parameters = primitive.defaultParameters;
     }
 
     SDFObject() : id(-1) {};
@@ -55,13 +75,94 @@ struct SDFObject {
 };
 
 
+// Packed object, 48 bytes. Transforms are rigid, so a quaternion and the position stand in for the inverse matrix;
+// the bounding sphere is the position plus a radius derived from the parameters
 struct SDFObjectGPUData {
-    glm::mat4 inverseModelMatrix; // 64 bytes (4x vec4)
-    glm::vec4 color;              // 16 bytes (vec4)
-    glm::vec4 paramsXYZ_type;     // 16 bytes (radius/halfX, halfY, halfZ, type)
+    glm::vec4 rotation;           // Unit quaternion (x, y, z, w), local -> world
+    glm::vec3 position;           // World translation, also the bounding sphere center
+    uint32_t colorLipschitz;      // RGBA8 unorm: rgb color, a = (getLipschitzBound() - 1) / 2
+    glm::vec3 parameters;         // Radii or half size
+    uint32_t typeFlags;           // Bits 0-7 SDFType, bits 8-15 blend group, bits 16-31 rounding (unorm16)
 };
+static_assert(sizeof(SDFObjectGPUData) == 48, "Must match the std430 SDFObjectGPUData in raymarch.frag");
 // --- END ADDITION ---
 
+constexpr uint32_t SDF_TYPE_MASK = 0xFFu;
+constexpr uint32_t SDF_BLEND_GROUP_SHIFT = 8;
+constexpr uint32_t SDF_BLEND_GROUP_MASK = 0xFFu;
+constexpr uint32_t SDF_ROUNDING_SHIFT = 16;
+
+inline SDFObjectGPUData SDFObject::toGPUData() const {
+    SDFObjectGPUData data;
+    glm::quat q = glm::quat_cast(glm::mat3(getModelMatrix()));
+    data.rotation = glm::vec4(q.x, q.y, q.z, q.w);
+    data.position = position;
+    // Lipschitz bound in [1, 3], rounded up to the next 8-bit step so it never gets smaller
+    float lipschitz = glm::ceil((getLipschitzBound() - 1.0f) * 0.5f * 255.0f) / 255.0f;
+    data.colorLipschitz = glm::packUnorm4x8(glm::vec4(color, lipschitz));
+    data.parameters = parameters;
+    data.typeFlags = (static_cast<uint32_t>(type) & SDF_TYPE_MASK)
+                   | ((static_cast<uint32_t>(blendGroup) & SDF_BLEND_GROUP_MASK) << SDF_BLEND_GROUP_SHIFT)
+                   | (static_cast<uint32_t>(glm::round(glm::clamp(rounding, 0.0f, 1.0f) * 65535.0f)) << SDF_ROUNDING_SHIFT);
+    return data;
+}
+
+// --- Unpacking, same as blendObject in raymarch.frag ---
+inline int getObjectType(const SDFObjectGPUData& data) {
+    return static_cast<int>(data.typeFlags & SDF_TYPE_MASK);
+}
+
+inline int getBlendGroup(const SDFObjectGPUData& data) {
+    return static_cast<int>((data.typeFlags >> SDF_BLEND_GROUP_SHIFT) & SDF_BLEND_GROUP_MASK);
+}
+
+// What the primitive functions take: parameters, w = rounding
+inline glm::vec4 getPrimitiveParameters(const SDFObjectGPUData& data) {
+    return glm::vec4(data.parameters, static_cast<float>(data.typeFlags >> SDF_ROUNDING_SHIFT) / 65535.0f);
+}
+
+// rgb color, w = Lipschitz bound
+inline glm::vec4 unpackColorLipschitz(const SDFObjectGPUData& data) {
+    glm::vec4 packed = glm::unpackUnorm4x8(data.colorLipschitz);
+    return glm::vec4(packed.x, packed.y, packed.z, 1.0f + 2.0f * packed.w);
+}
+
+inline float getBoundingRadius(const SDFObjectGPUData& data) {
+    const SDFPrimitive* primitive = SDFPrimitives::find(getObjectType(data));
+    return primitive ? primitive->boundingRadius(getPrimitiveParameters(data)) : 0.0f;
+}
+
+// Rotates v by the unit quaternion q (x, y, z, w)
+inline glm::vec3 quatRotate(const glm::vec4& q, const glm::vec3& v) {
+    glm::vec3 axis = glm::vec3(q.x, q.y, q.z);
+    return v + 2.0f * cross(axis, cross(axis, v) + q.w * v);
+}
+
+// World-space AABB of the surface: the primitive's local extents rotated into world space.
+// Just the position for unknown types, like getBoundingRadius
+inline void getWorldBounds(const SDFObjectGPUData& data, glm::vec3& outMin, glm::vec3& outMax) {
+    const SDFPrimitive* primitive = SDFPrimitives::find(getObjectType(data));
+    glm::vec3 local = primitive ? primitive->localExtent(getPrimitiveParameters(data)) : glm::vec3(0.0f);
+    glm::vec3 extent = abs(quatRotate(data.rotation, glm::vec3(1.0f, 0.0f, 0.0f))) * local.x
+                     + abs(quatRotate(data.rotation, glm::vec3(0.0f, 1.0f, 0.0f))) * local.y
+                     + abs(quatRotate(data.rotation, glm::vec3(0.0f, 0.0f, 1.0f))) * local.z;
+    outMin = data.position - extent;
+    outMax = data.position + extent;
+}
+
+// Order the renderers take the objects in: by blend group, then by type, so every blend group and every type
+// within it is one contiguous range. Stable, objects otherwise keep their list order.
+// outOrder[gpuIndex] is the index of that object in 'objects'
+inline void getGPUOrder(const std::vector<SDFObject>& objects, std::vector<int>& outOrder) {
+    outOrder.resize(objects.size());
+    for (size_t i = 0; i < objects.size(); ++i) outOrder[i] = static_cast<int>(i);
+    std::stable_sort(outOrder.begin(), outOrder.end(), [&](int a, int b) {
+        const SDFObject& objectA = objects[a];
+        const SDFObject& objectB = objects[b];
+        return objectA.blendGroup != objectB.blendGroup ? objectA.blendGroup < objectB.blendGroup : objectA.type < objectB.type;
+    });
+}
+
 inline int findObjectIndex(const std::vector<SDFObject>& objects, int uniqueId) {
     for (size_t i = 0; i < objects.size(); ++i) {
         if (objects[i].id == uniqueId) {
@@ -69,4 +170,36 @@ inline int findObjectIndex(const std::vector<SDFObject>& objects, int uniqueId)
         }
     }
     return -1; // Not found
-}
\ No newline at end of file
+}
+
+// Starting scene shared by the editor and the headless renderer
+inline void createDefaultScene(std::vector<SDFObject>& objects, int& nextSdfId) {
+    SDFObject sphere1(nextSdfId++);
+    sphere1.type = SDFType::SPHERE;
+    sphere1.position = glm::vec3(-1.5f, 0.0f, 0.0f);
+    sphere1.parameters = glm::vec3(0.8f); // Set all radii to 0.8 for a uniform sphere
+    sphere1.color = glm::vec3(1.0f, 1.0f, 1.0f);
+    objects.push_back(sphere1);
+
+    SDFObject box1(nextSdfId++);
+    box1.type = SDFType::BOX;
+    box1.position = glm::vec3(1.5f, 0.0f, 0.0f);
+    box1.parameters = glm::vec3(0.6f, 0.7f, 0.8f); // Set half-sizes directly
+    box1.color = glm::vec3(1.0f, 1.0f, 1.0f);
+    objects.push_back(box1);
+}
+
+// One object of every primitive type in a row along x, each with its registry defaults (headless --primitives)
+inline void createPrimitiveScene(std::vector<SDFObject>& objects, int& nextSdfId) {
+    const int count = static_cast<int>(SDFType::COUNT);
+    for (int type = 0; type < count; ++type) {
+        SDFObject object(nextSdfId++, static_cast<SDFType>(type));
+        object.position = glm::vec3(1.3f * (static_cast<float>(type) - 0.5f * static_cast<float>(count - 1)), 0.0f, 0.0f);
+        object.rotation = glm::vec3(60.0f, 0.0f, 20.0f); // Tilted so the shapes along z show their profile
+        object.color = glm::vec3(0.5f + 0.5f * glm::cos(1.7f * static_cast<float>(type)),
+                                 0.5f + 0.5f * glm::cos(1.7f * static_cast<float>(type) + 2.1f),
+                                 0.5f + 0.5f * glm::cos(1.7f * static_cast<float>(type) + 4.2f));
+        if (object.type == SDFType::PLANE) object.parameters = glm::vec3(0.5f, 0.5f, 0.0f);
+        objects.push_back(object);
+    }
+}
@@ -0,0 +1,132 @@
+//
+// Growable SSBO ring for the scene objects
+//
+
+#include "SDFObjectBuffer.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+SDFObjectBuffer::~SDFObjectBuffer() {
+    destroy();
+}
+
+void SDFObjectBuffer::init(GLuint bindingPoint, GLuint bvhBindingPoint, int initialCapacity) {
+    m_bindingPoint = bindingPoint;
+    m_bvhBindingPoint = bvhBindingPoint;
+    m_capacity = 0;
+    reserve(std::max(1, initialCapacity));
+}
+
+void SDFObjectBuffer::destroy() {
+    m_ring.destroy();
+    m_bvhRing.destroy();
+    m_count = 0;
+    m_capacity = 0;
+    m_bvhCapacity = 0;
+    m_uploadedIds.clear(); // Re-pack everything after a re-init
+    for (auto& slotVersions : m_slotVersions) slotVersions.clear();
+}
+
+void SDFObjectBuffer::reserve(int objectCount) {
+    if (objectCount <= m_capacity) return;
+
+    // Double until it fits, so adding objects one by one reallocates O(log n) times
+    int newCapacity = std::max(1, m_capacity);
+    while (newCapacity < objectCount) newCapacity *= 2;
+
+    if (!m_ring.create(GL_SHADER_STORAGE_BUFFER, static_cast<GLsizeiptr>(newCapacity) * sizeof(SDFObjectGPUData))) {
+        m_capacity = 0;
+        return;
+    }
+    // New slots hold nothing yet, the CPU mirror is still valid and gets copied in full
+    for (auto& slotVersions : m_slotVersions) slotVersions.clear();
+
+    std::cout << "SDF object buffer capacity: " << m_capacity << " -> " << newCapacity << " objects" << std::endl;
+    m_capacity = newCapacity;
+}
+
+void SDFObjectBuffer::upload(std::vector<SDFObject>& objects) {
+    m_structureChanged = (m_count != static_cast<int>(objects.size()));
+    m_count = static_cast<int>(objects.size());
+    m_changed.clear();
+
+    getGPUOrder(objects, m_objectIndices);
+    m_gpuIndices.resize(m_count);
+    for (int i = 0; i < m_count; ++i) m_gpuIndices[m_objectIndices[i]] = i;
+
+    reserve(m_count);
+    if (!m_ring.isCreated()) return;
+
+    // Find what changed: edited objects, plus indices that now hold another object (add / delete shifts indices,
+    // a new blend group moves the object)
+    m_data.resize(m_count);
+    m_uploadedIds.resize(m_count, -1);
+    m_versions.resize(m_count, 0);
+    for (int i = 0; i < m_count; ++i) {
+        SDFObject& obj = objects[m_objectIndices[i]];
+        if (obj.gpuDirty || m_uploadedIds[i] != obj.id) {
+            if (m_uploadedIds[i] != obj.id) m_structureChanged = true;
+            m_data[i] = obj.toGPUData();
+            m_uploadedIds[i] = obj.id;
+            m_versions[i] = m_nextVersion++;
+            obj.gpuDirty = false;
+            m_changed.push_back(i);
+        }
+    }
+
+    // This frame's slot still has the data from SLOT_COUNT frames ago, copy each run of newer objects
+    auto* slot = static_cast<SDFObjectGPUData*>(m_ring.acquireSlot());
+    std::vector<uint64_t>& slotVersions = m_slotVersions[m_ring.getSlotIndex()];
+    slotVersions.resize(m_count, 0);
+    for (int i = 0; i < m_count;) {
+        if (slotVersions[i] == m_versions[i]) { ++i; continue; }
+        int first = i;
+        while (i < m_count && slotVersions[i] != m_versions[i]) {
+            slotVersions[i] = m_versions[i];
+            ++i;
+        }
+        std::memcpy(slot + first, &m_data[first], static_cast<size_t>(i - first) * sizeof(SDFObjectGPUData));
+    }
+
+    m_ring.bindSlot(m_bindingPoint);
+
+    // Moving objects only refits, anything else changes the leaves and needs a new tree
+    if (m_structureChanged) {
+        m_bvh.build(m_data);
+        ++m_bvhVersion;
+    } else if (!m_changed.empty()) {
+        m_bvh.refit(m_data, m_changed);
+        ++m_bvhVersion;
+    }
+    uploadBVH();
+}
+
+void SDFObjectBuffer::uploadBVH() {
+    const std::vector<BVHNode>& nodes = m_bvh.getNodes();
+    const int nodeCount = static_cast<int>(nodes.size());
+
+    if (nodeCount > m_bvhCapacity || !m_bvhRing.isCreated()) {
+        int newCapacity = std::max(1, m_bvhCapacity);
+        while (newCapacity < nodeCount) newCapacity *= 2;
+        if (!m_bvhRing.create(GL_SHADER_STORAGE_BUFFER, static_cast<GLsizeiptr>(newCapacity) * sizeof(BVHNode))) {
+            m_bvhCapacity = 0;
+            return;
+        }
+        m_bvhCapacity = newCapacity;
+        m_bvhSlotVersions.fill(0);
+    }
+
+    void* slot = m_bvhRing.acquireSlot();
+    uint64_t& slotVersion = m_bvhSlotVersions[m_bvhRing.getSlotIndex()];
+    if (slotVersion != m_bvhVersion && nodeCount > 0) {
+        std::memcpy(slot, nodes.data(), static_cast<size_t>(nodeCount) * sizeof(BVHNode));
+    }
+    slotVersion = m_bvhVersion;
+    m_bvhRing.bindSlot(m_bvhBindingPoint);
+}
+
+void SDFObjectBuffer::endFrame() {
+    if (m_ring.isCreated()) m_ring.fenceSlot();
+    if (m_bvhRing.isCreated()) m_bvhRing.fenceSlot();
+}
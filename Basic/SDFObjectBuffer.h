@@ -0,0 +1,88 @@
+//
+// GPU storage for the scene objects: a std430 shader storage buffer (SDFBlock in raymarch.frag)
+// that grows geometrically, so the object count is only limited by GPU memory.
+// Only objects flagged with SDFObject::gpuDirty (or whose slot now holds a different object) are re-packed.
+// The buffer is a persistently mapped ring with one copy per frame in flight; each copy only receives
+// the objects that changed since it was last written.
+// The object BVH (BVHBlock) lives next to it: refit when objects move, rebuilt when objects are added, removed or reordered.
+// The buffer holds the objects in getGPUOrder (by blend group, then type) while the editor's list keeps the user's
+// order; every index that reaches or comes back from the GPU (BVH leaves, tile lists, CSG pushes, picks) is a
+// buffer index, getObjectIndex / getGPUIndex translate.
+//
+#pragma once
+#include <glad/glad.h>
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "Basic/SDFObject.h"
+#include "Basic/PersistentRingBuffer.h"
+#include "Basic/SDFBVH.h"
+
+class SDFObjectBuffer {
+public:
+    SDFObjectBuffer() = default;
+    ~SDFObjectBuffer();
+
+    SDFObjectBuffer(const SDFObjectBuffer&) = delete;
+    SDFObjectBuffer& operator=(const SDFObjectBuffer&) = delete;
+
+    // Creates the rings and remembers the SSBO binding points used by the shader
+    void init(GLuint bindingPoint, GLuint bvhBindingPoint, int initialCapacity = 16);
+    void destroy();
+
+    // Re-packs the objects that changed since the last call and clears their dirty flag, then writes
+    // this frame's ring slots (objects and BVH) and binds them. Reallocates only when the objects no longer fit
+    void upload(std::vector<SDFObject>& objects);
+    // Call after the draw calls that read this frame's slot
+    void endFrame();
+
+    // Buffer indices re-packed by the last upload() call, in increasing order
+    const std::vector<int>& getChangedIndices() const { return m_changed; }
+    // Packed data of every object, same content and order as the GPU buffer
+    const std::vector<SDFObjectGPUData>& getData() const { return m_data; }
+    // Buffer index -> index in the list given to upload(), and back. -1 when out of range
+    int getObjectIndex(int gpuIndex) const {
+        return (gpuIndex >= 0 && gpuIndex < static_cast<int>(m_objectIndices.size())) ? m_objectIndices[gpuIndex] : -1;
+    }
+    int getGPUIndex(int objectIndex) const {
+        return (objectIndex >= 0 && objectIndex < static_cast<int>(m_gpuIndices.size())) ? m_gpuIndices[objectIndex] : -1;
+    }
+    // Buffer index of every object in list order (for remapCSGObjects)
+    const std::vector<int>& getGPUIndices() const { return m_gpuIndices; }
+    // True if the last upload() added, removed or reordered objects (in the buffer, e.g. a new blend group)
+    bool wasStructureChanged() const { return m_structureChanged; }
+    const SDFBVH& getBVH() const { return m_bvh; }
+
+    int getCount() const { return m_count; }
+    int getCapacity() const { return m_capacity; }
+    int getStallCount() const { return m_ring.getStallCount(); }
+
+private:
+    void reserve(int objectCount);
+    void uploadBVH();
+
+    PersistentRingBuffer m_ring;
+    GLuint m_bindingPoint = 0;
+    int m_count = 0;
+    int m_capacity = 0;
+
+    std::vector<SDFObjectGPUData> m_data; // CPU mirror of the buffer
+    std::vector<int> m_uploadedIds;       // Object id stored in each index
+    std::vector<int> m_objectIndices;     // Buffer index -> list index
+    std::vector<int> m_gpuIndices;        // List index -> buffer index
+    std::vector<int> m_changed;
+    bool m_structureChanged = true;
+
+    // Change counter per object, and the counter each ring slot last received
+    uint64_t m_nextVersion = 1;
+    std::vector<uint64_t> m_versions;
+    std::array<std::vector<uint64_t>, PersistentRingBuffer::SLOT_COUNT> m_slotVersions;
+
+    // BVH ring, a slot gets the whole node array whenever it is behind
+    SDFBVH m_bvh;
+    PersistentRingBuffer m_bvhRing;
+    GLuint m_bvhBindingPoint = 0;
+    int m_bvhCapacity = 0;
+    uint64_t m_bvhVersion = 1;
+    std::array<uint64_t, PersistentRingBuffer::SLOT_COUNT> m_bvhSlotVersions = {};
+};
@@ -0,0 +1,391 @@
+//
+// Primitive registry, the C++ bodies and their GLSL twins
+//
+
+#include "SDFPrimitives.h"
+#include <cmath>
+#include <sstream>
+
+using namespace glm;
+
+// -- SPHERE: ellipsoid, bound of Inigo Quilez (not exact inside, see SDFObject::getLipschitzBound) --
+static float sdEllipsoidLocal(const vec3& p, const vec4& params) {
+    vec3 r = max(vec3(params), vec3(1e-6f));
+    float k0 = length(p / r);
+    float k1 = length(p / (r * r));
+    if (k1 < 1e-7f) return length(p) - length(r);
+    return k0 * (k0 - 1.0f) / k1;
+}
+
+static vec4 sdgEllipsoidLocal(const vec3& p, const vec4& params) {
+    vec3 r = max(vec3(params), vec3(1e-6f));
+    vec3 pr = p / r;
+    vec3 prr = pr / r;
+    float k0 = length(pr);
+    float k1 = length(prr);
+    if (k1 < 1e-7f) {
+        float len = length(p);
+        return vec4(len - length(r), len > 0.0f ? p / len : vec3(0.0f));
+    }
+    vec3 gradK0 = prr / k0;
+    vec3 gradK1 = prr / (r * r * k1);
+    float dist = k0 * (k0 - 1.0f) / k1;
+    return vec4(dist, ((2.0f * k0 - 1.0f) * gradK0 - dist * gradK1) / k1);
+}
+
+static const char* const ELLIPSOID_GLSL = R"(
+float sdEllipsoidLocal(vec3 p, vec4 params) {
+    vec3 r = max(params.xyz, vec3(1e-6));
+    float k0 = length(p / r);
+    float k1 = length(p / (r * r));
+    if (k1 < 1e-7) return length(p) - length(r);
+    return k0 * (k0 - 1.0) / k1;
+}
+
+vec4 sdgEllipsoidLocal(vec3 p, vec4 params) {
+    vec3 r = max(params.xyz, vec3(1e-6));
+    vec3 pr = p / r;
+    vec3 prr = pr / r;
+    float k0 = length(pr);
+    float k1 = length(prr);
+    if (k1 < 1e-7) {
+        float len = length(p);
+        return vec4(len - length(r), len > 0.0 ? p / len : vec3(0.0));
+    }
+    // d = k0 * (k0 - 1) / k1, with grad(k0) = p / (r^2 k0) and grad(k1) = p / (r^4 k1)
+    vec3 gradK0 = prr / k0;
+    vec3 gradK1 = prr / (r * r * k1);
+    float dist = k0 * (k0 - 1.0) / k1;
+    return vec4(dist, ((2.0 * k0 - 1.0) * gradK0 - dist * gradK1) / k1);
+}
+)";
+
+// -- BOX --
+static float sdBoxLocal(const vec3& p, const vec4& params) {
+    vec3 q = abs(p) - vec3(params);
+    return length(max(q, 0.0f)) + min(max(q.x, max(q.y, q.z)), 0.0f);
+}
+
+static vec4 sdgBoxLocal(const vec3& p, const vec4& params) {
+    vec3 q = abs(p) - vec3(params);
+    vec3 s = sign(p);
+    float inner = max(q.x, max(q.y, q.z));
+    if (inner > 0.0f) {
+        vec3 outer = max(q, 0.0f);
+        float len = length(outer);
+        return vec4(len, s * outer / len);
+    }
+    vec3 axis = (q.x > q.y && q.x > q.z) ? vec3(1.0f, 0.0f, 0.0f) : ((q.y > q.z) ? vec3(0.0f, 1.0f, 0.0f) : vec3(0.0f, 0.0f, 1.0f));
+    return vec4(inner, s * axis);
+}
+
+static const char* const BOX_GLSL = R"(
+float sdBoxLocal(vec3 p, vec4 params) {
+    vec3 q = abs(p) - params.xyz;
+    return length(max(q, 0.0)) + min(max(q.x, max(q.y, q.z)), 0.0);
+}
+
+vec4 sdgBoxLocal(vec3 p, vec4 params) {
+    vec3 q = abs(p) - params.xyz;
+    vec3 s = sign(p);
+    float inner = max(q.x, max(q.y, q.z));
+    if (inner > 0.0) {
+        // Outside: direction to the closest point on the box
+        vec3 outer = max(q, 0.0);
+        float len = length(outer);
+        return vec4(len, s * outer / len);
+    }
+    // Inside: normal of the closest face
+    vec3 axis = (q.x > q.y && q.x > q.z) ? vec3(1.0, 0.0, 0.0) : ((q.y > q.z) ? vec3(0.0, 1.0, 0.0) : vec3(0.0, 0.0, 1.0));
+    return vec4(inner, s * axis);
+}
+)";
+
+// -- TORUS: distance to the ring circle minus the tube radius --
+static float sdTorusLocal(const vec3& p, const vec4& params) {
+    vec2 q = vec2(length(vec2(p)) - params.x, p.z);
+    return length(q) - params.y;
+}
+
+static vec4 sdgTorusLocal(const vec3& p, const vec4& params) {
+    float radial = length(vec2(p));
+    vec2 q = vec2(radial - params.x, p.z);
+    float len = length(q);
+    vec2 n = len > 0.0f ? q / len : vec2(0.0f, 1.0f);
+    vec2 dir = radial > 0.0f ? vec2(p) / radial : vec2(1.0f, 0.0f);
+    return vec4(len - params.y, dir * n.x, n.y);
+}
+
+static const char* const TORUS_GLSL = R"(
+float sdTorusLocal(vec3 p, vec4 params) {
+    vec2 q = vec2(length(p.xy) - params.x, p.z);
+    return length(q) - params.y;
+}
+
+vec4 sdgTorusLocal(vec3 p, vec4 params) {
+    float radial = length(p.xy);
+    vec2 q = vec2(radial - params.x, p.z);
+    float len = length(q);
+    vec2 n = len > 0.0 ? q / len : vec2(0.0, 1.0);
+    vec2 dir = radial > 0.0 ? p.xy / radial : vec2(1.0, 0.0);
+    return vec4(len - params.y, dir * n.x, n.y);
+}
+)";
+
+// -- CAPSULE: distance to the segment minus the radius --
+static float sdCapsuleLocal(const vec3& p, const vec4& params) {
+    return length(vec3(p.x, p.y, p.z - clamp(p.z, -params.y, params.y))) - params.x;
+}
+
+static vec4 sdgCapsuleLocal(const vec3& p, const vec4& params) {
+    vec3 c = vec3(p.x, p.y, p.z - clamp(p.z, -params.y, params.y));
+    float len = length(c);
+    return vec4(len - params.x, len > 0.0f ? c / len : vec3(1.0f, 0.0f, 0.0f));
+}
+
+static const char* const CAPSULE_GLSL = R"(
+float sdCapsuleLocal(vec3 p, vec4 params) {
+    return length(vec3(p.xy, p.z - clamp(p.z, -params.y, params.y))) - params.x;
+}
+
+vec4 sdgCapsuleLocal(vec3 p, vec4 params) {
+    vec3 c = vec3(p.xy, p.z - clamp(p.z, -params.y, params.y));
+    float len = length(c);
+    return vec4(len - params.x, len > 0.0 ? c / len : vec3(1.0, 0.0, 0.0));
+}
+)";
+
+// -- CYLINDER: a box in (radial, z) --
+static float sdCylinderLocal(const vec3& p, const vec4& params) {
+    vec2 d = vec2(length(vec2(p)) - params.x, std::abs(p.z) - params.y);
+    return min(max(d.x, d.y), 0.0f) + length(max(d, 0.0f));
+}
+
+static vec4 sdgCylinderLocal(const vec3& p, const vec4& params) {
+    float radial = length(vec2(p));
+    vec2 d = vec2(radial - params.x, std::abs(p.z) - params.y);
+    vec2 dir = radial > 0.0f ? vec2(p) / radial : vec2(1.0f, 0.0f);
+    float side = p.z < 0.0f ? -1.0f : 1.0f;
+    float inner = max(d.x, d.y);
+    if (inner > 0.0f) {
+        vec2 outer = max(d, 0.0f);
+        float len = length(outer);
+        return vec4(len, dir * (outer.x / len), side * outer.y / len);
+    }
+    return d.x > d.y ? vec4(inner, dir, 0.0f) : vec4(inner, 0.0f, 0.0f, side);
+}
+
+static const char* const CYLINDER_GLSL = R"(
+float sdCylinderLocal(vec3 p, vec4 params) {
+    vec2 d = vec2(length(p.xy) - params.x, abs(p.z) - params.y);
+    return min(max(d.x, d.y), 0.0) + length(max(d, 0.0));
+}
+
+vec4 sdgCylinderLocal(vec3 p, vec4 params) {
+    float radial = length(p.xy);
+    vec2 d = vec2(radial - params.x, abs(p.z) - params.y);
+    vec2 dir = radial > 0.0 ? p.xy / radial : vec2(1.0, 0.0);
+    float side = p.z < 0.0 ? -1.0 : 1.0;
+    float inner = max(d.x, d.y);
+    if (inner > 0.0) {
+        vec2 outer = max(d, 0.0);
+        float len = length(outer);
+        return vec4(len, dir * (outer.x / len), side * outer.y / len);
+    }
+    return d.x > d.y ? vec4(inner, dir, 0.0) : vec4(inner, 0.0, 0.0, side);
+}
+)";
+
+// -- CONE: capped cone of Inigo Quilez with a zero top radius, in (radial, z). The nearer of the cap vector (ca)
+// and the slant vector (cb) gives the distance, its direction the gradient --
+static float sdConeLocal(const vec3& p, const vec4& params) {
+    vec2 q = vec2(length(vec2(p)), p.z);
+    vec2 apex = vec2(0.0f, params.y);
+    vec2 slant = vec2(-params.x, 2.0f * params.y);
+    vec2 ca = vec2(q.x - min(q.x, q.y < 0.0f ? params.x : 0.0f), std::abs(q.y) - params.y);
+    vec2 cb = q - apex + slant * clamp(dot(apex - q, slant) / dot(slant, slant), 0.0f, 1.0f);
+    float s = (cb.x < 0.0f && ca.y < 0.0f) ? -1.0f : 1.0f;
+    return s * std::sqrt(min(dot(ca, ca), dot(cb, cb)));
+}
+
+static vec4 sdgConeLocal(const vec3& p, const vec4& params) {
+    float radial = length(vec2(p));
+    vec2 q = vec2(radial, p.z);
+    vec2 apex = vec2(0.0f, params.y);
+    vec2 slant = vec2(-params.x, 2.0f * params.y);
+    vec2 ca = vec2(q.x - min(q.x, q.y < 0.0f ? params.x : 0.0f), std::abs(q.y) - params.y);
+    vec2 cb = q - apex + slant * clamp(dot(apex - q, slant) / dot(slant, slant), 0.0f, 1.0f);
+    float s = (cb.x < 0.0f && ca.y < 0.0f) ? -1.0f : 1.0f;
+    // d|ca| / dq = (ca.x, ca.y * sign(q.y)) / |ca|; cb is perpendicular to the slant (or ends on it), so d|cb| / dq = cb / |cb|
+    vec2 v = dot(ca, ca) < dot(cb, cb) ? vec2(ca.x, q.y < 0.0f ? -ca.y : ca.y) : cb;
+    float len = length(v);
+    vec2 n = len > 0.0f ? s * v / len : vec2(0.0f, 1.0f);
+    vec2 dir = radial > 0.0f ? vec2(p) / radial : vec2(1.0f, 0.0f);
+    return vec4(s * len, dir * n.x, n.y);
+}
+
+static const char* const CONE_GLSL = R"(
+float sdConeLocal(vec3 p, vec4 params) {
+    vec2 q = vec2(length(p.xy), p.z);
+    vec2 apex = vec2(0.0, params.y);
+    vec2 slant = vec2(-params.x, 2.0 * params.y);
+    vec2 ca = vec2(q.x - min(q.x, q.y < 0.0 ? params.x : 0.0), abs(q.y) - params.y);
+    vec2 cb = q - apex + slant * clamp(dot(apex - q, slant) / dot(slant, slant), 0.0, 1.0);
+    float s = (cb.x < 0.0 && ca.y < 0.0) ? -1.0 : 1.0;
+    return s * sqrt(min(dot(ca, ca), dot(cb, cb)));
+}
+
+vec4 sdgConeLocal(vec3 p, vec4 params) {
+    float radial = length(p.xy);
+    vec2 q = vec2(radial, p.z);
+    vec2 apex = vec2(0.0, params.y);
+    vec2 slant = vec2(-params.x, 2.0 * params.y);
+    vec2 ca = vec2(q.x - min(q.x, q.y < 0.0 ? params.x : 0.0), abs(q.y) - params.y);
+    vec2 cb = q - apex + slant * clamp(dot(apex - q, slant) / dot(slant, slant), 0.0, 1.0);
+    float s = (cb.x < 0.0 && ca.y < 0.0) ? -1.0 : 1.0;
+    vec2 v = dot(ca, ca) < dot(cb, cb) ? vec2(ca.x, q.y < 0.0 ? -ca.y : ca.y) : cb;
+    float len = length(v);
+    vec2 n = len > 0.0 ? s * v / len : vec2(0.0, 1.0);
+    vec2 dir = radial > 0.0 ? p.xy / radial : vec2(1.0, 0.0);
+    return vec4(s * len, dir * n.x, n.y);
+}
+)";
+
+// -- PLANE: bounded so it keeps a bounding sphere, no inside --
+static float sdPlaneLocal(const vec3& p, const vec4& params) {
+    vec2 q = max(abs(vec2(p)) - vec2(params), 0.0f);
+    return length(vec3(q, p.z));
+}
+
+static vec4 sdgPlaneLocal(const vec3& p, const vec4& params) {
+    vec3 v = vec3(sign(vec2(p)) * max(abs(vec2(p)) - vec2(params), 0.0f), p.z);
+    float len = length(v);
+    return vec4(len, len > 0.0f ? v / len : vec3(0.0f, 0.0f, 1.0f));
+}
+
+static const char* const PLANE_GLSL = R"(
+float sdPlaneLocal(vec3 p, vec4 params) {
+    vec2 q = max(abs(p.xy) - params.xy, 0.0);
+    return length(vec3(q, p.z));
+}
+
+vec4 sdgPlaneLocal(vec3 p, vec4 params) {
+    vec3 v = vec3(sign(p.xy) * max(abs(p.xy) - params.xy, 0.0), p.z);
+    float len = length(v);
+    return vec4(len, len > 0.0 ? v / len : vec3(0.0, 0.0, 1.0));
+}
+)";
+
+// -- ROUNDED_BOX: the box shrunk by the corner radius, then inflated by it (same outer size) --
+static float roundedBoxRadius(const vec4& params) {
+    return clamp(params.w, 0.0f, 1.0f) * min(params.x, min(params.y, params.z));
+}
+
+static float sdRoundedBoxLocal(const vec3& p, const vec4& params) {
+    float radius = roundedBoxRadius(params);
+    return sdBoxLocal(p, vec4(vec3(params) - radius, 0.0f)) - radius;
+}
+
+static vec4 sdgRoundedBoxLocal(const vec3& p, const vec4& params) {
+    float radius = roundedBoxRadius(params);
+    vec4 distGrad = sdgBoxLocal(p, vec4(vec3(params) - radius, 0.0f));
+    return vec4(distGrad.x - radius, distGrad.y, distGrad.z, distGrad.w);
+}
+
+static const char* const ROUNDED_BOX_GLSL = R"(
+float sdRoundedBoxLocal(vec3 p, vec4 params) {
+    float radius = clamp(params.w, 0.0, 1.0) * min(params.x, min(params.y, params.z));
+    return sdBoxLocal(p, vec4(params.xyz - radius, 0.0)) - radius;
+}
+
+vec4 sdgRoundedBoxLocal(vec3 p, vec4 params) {
+    float radius = clamp(params.w, 0.0, 1.0) * min(params.x, min(params.y, params.z));
+    vec4 distGrad = sdgBoxLocal(p, vec4(params.xyz - radius, 0.0));
+    return vec4(distGrad.x - radius, distGrad.yzw);
+}
+)";
+
+// Indexed by SDFType, the GLSL is emitted in this order (the rounded box calls the box)
+static const SDFPrimitive PRIMITIVES[] = {
+    {SDFType::SPHERE, "Sphere", "Radius (X/Y/Z)", 3, vec3(0.5f), false,
+     sdEllipsoidLocal, sdgEllipsoidLocal,
+     [](const vec4& params) { return vec3(params); },
+     [](const vec4& params) { return max(params.x, max(params.y, params.z)); },
+     "Ellipsoid", ELLIPSOID_GLSL, "max(params.x, max(params.y, params.z))"},
+    {SDFType::BOX, "Box", "Half Size", 3, vec3(0.5f), true,
+     sdBoxLocal, sdgBoxLocal,
+     [](const vec4& params) { return vec3(params); },
+     [](const vec4& params) { return length(vec3(params)); },
+     "Box", BOX_GLSL, "length(params.xyz)"},
+    {SDFType::TORUS, "Torus", "Ring / Tube Radius", 2, vec3(0.5f, 0.15f, 0.0f), true,
+     sdTorusLocal, sdgTorusLocal,
+     [](const vec4& params) { return vec3(params.x + params.y, params.x + params.y, params.y); },
+     [](const vec4& params) { return params.x + params.y; },
+     "Torus", TORUS_GLSL, "params.x + params.y"},
+    {SDFType::CAPSULE, "Capsule", "Radius / Half Length", 2, vec3(0.25f, 0.4f, 0.0f), true,
+     sdCapsuleLocal, sdgCapsuleLocal,
+     [](const vec4& params) { return vec3(params.x, params.x, params.x + params.y); },
+     [](const vec4& params) { return params.x + params.y; },
+     "Capsule", CAPSULE_GLSL, "params.x + params.y"},
+    {SDFType::CYLINDER, "Cylinder", "Radius / Half Height", 2, vec3(0.4f, 0.5f, 0.0f), true,
+     sdCylinderLocal, sdgCylinderLocal,
+     [](const vec4& params) { return vec3(params.x, params.x, params.y); },
+     [](const vec4& params) { return length(vec2(params)); },
+     "Cylinder", CYLINDER_GLSL, "length(params.xy)"},
+    {SDFType::CONE, "Cone", "Base Radius / Half Height", 2, vec3(0.4f, 0.5f, 0.0f), true,
+     sdConeLocal, sdgConeLocal,
+     [](const vec4& params) { return vec3(params.x, params.x, params.y); },
+     [](const vec4& params) { return length(vec2(params)); },
+     "Cone", CONE_GLSL, "length(params.xy)"},
+    {SDFType::PLANE, "Plane", "Half Size", 2, vec3(2.0f, 2.0f, 0.0f), true,
+     sdPlaneLocal, sdgPlaneLocal,
+     [](const vec4& params) { return vec3(params.x, params.y, 0.0f); },
+     [](const vec4& params) { return length(vec2(params)); },
+     "Plane", PLANE_GLSL, "length(params.xy)"},
+    {SDFType::ROUNDED_BOX, "Rounded Box", "Half Size", 3, vec3(0.5f), true,
+     sdRoundedBoxLocal, sdgRoundedBoxLocal,
+     [](const vec4& params) { return vec3(params); },
+     [](const vec4& params) { return length(vec3(params)); },
+     "RoundedBox", ROUNDED_BOX_GLSL, "length(params.xyz)"},
+};
+static_assert(sizeof(PRIMITIVES) / sizeof(PRIMITIVES[0]) == static_cast<size_t>(SDFType::COUNT), "One entry per SDFType");
+
+const SDFPrimitive& SDFPrimitives::get(SDFType type) {
+    return PRIMITIVES[static_cast<int>(type)];
+}
+
+const SDFPrimitive* SDFPrimitives::find(int type) {
+    if (type < 0 || type >= static_cast<int>(SDFType::COUNT)) return nullptr;
+    return &PRIMITIVES[type];
+}
+
+std::string SDFPrimitives::generateGLSL() {
+    std::ostringstream out;
+    out << "// Generated by SDFPrimitives for " << static_cast<int>(SDFType::COUNT) << " primitive types\n";
+    for (const SDFPrimitive& primitive : PRIMITIVES) out << primitive.glslSource;
+
+    out << "\n// Distance of a primitive type, with computeGradient also its local space gradient, as (dist, gradient)\n";
+    out << "vec4 evaluatePrimitive(uint type, vec3 p, vec4 params, bool computeGradient) {\n";
+    out << "    switch (type) {\n";
+    for (const SDFPrimitive& primitive : PRIMITIVES) {
+        out << "        case " << static_cast<int>(primitive.type) << "u: return computeGradient ? sdg" << primitive.glslName
+            << "Local(p, params) : vec4(sd" << primitive.glslName << "Local(p, params), 0.0, 0.0, 0.0);\n";
+    }
+    out << "    }\n";
+    out << "    return vec4(MAX_DIST, 0.0, 0.0, 0.0);\n}\n";
+
+    out << "\nfloat primitiveBoundingRadius(uint type, vec4 params) {\n";
+    out << "    switch (type) {\n";
+    for (const SDFPrimitive& primitive : PRIMITIVES) {
+        out << "        case " << static_cast<int>(primitive.type) << "u: return " << primitive.glslBoundingRadius << ";\n";
+    }
+    out << "    }\n";
+    out << "    return 0.0;\n}\n";
+    return out.str();
+}
+
+std::string SDFPrimitives::insertInto(const std::string& fragmentSource) {
+    size_t markerPos = fragmentSource.find(MARKER);
+    if (markerPos == std::string::npos) return "";
+    return fragmentSource.substr(0, markerPos) + generateGLSL() + fragmentSource.substr(markerPos + std::char_traits<char>::length(MARKER));
+}
@@ -0,0 +1,44 @@
+//
+// Primitive registry: every SDFType with its distance function in C++ and in GLSL side by side, so a new shape
+// is one entry here (plus its lanes in SDFEvaluatorSIMD.inl). Shapes sit at the local origin; their parameters
+// are the object's (xyz) and its rounding (w). The GLSL is spliced into raymarch.frag at MARKER together with
+// the evaluatePrimitive / primitiveBoundingRadius switches over the types.
+//
+#pragma once
+#include <glm/glm.hpp>
+#include <string>
+#include "Basic/SDFType.h"
+
+struct SDFPrimitive {
+    SDFType type;
+    const char* name;               // UI and default object names
+    const char* parameterLabel;     // Inspector label of the parameters
+    int parameterCount;             // Leading components of the parameters the shape reads
+    glm::vec3 defaultParameters;
+    bool exact;                     // Distance is exact (Lipschitz 1), else SDFObject::getLipschitzBound estimates it
+
+    // Distance, and distance plus local space gradient as (dist, gradient)
+    float (*distance)(const glm::vec3& p, const glm::vec4& params);
+    glm::vec4 (*distanceGradient)(const glm::vec3& p, const glm::vec4& params);
+    glm::vec3 (*localExtent)(const glm::vec4& params);  // Half size of the local AABB
+    float (*boundingRadius)(const glm::vec4& params);   // Sphere around the local origin
+
+    const char* glslName;           // The GLSL defines sd<glslName>Local and sdg<glslName>Local
+    const char* glslSource;
+    const char* glslBoundingRadius; // Expression of 'params'
+};
+
+class SDFPrimitives {
+public:
+    static constexpr const char* MARKER = "// @PRIMITIVES@";
+
+    // Indexed by SDFType
+    static const SDFPrimitive& get(SDFType type);
+    // nullptr for unknown types
+    static const SDFPrimitive* find(int type);
+
+    // Every primitive's GLSL, then the switches raymarch.frag dispatches through
+    static std::string generateGLSL();
+    // fragmentSource with generateGLSL() at MARKER, empty if the marker is missing
+    static std::string insertInto(const std::string& fragmentSource);
+};
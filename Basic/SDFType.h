@@ -0,0 +1,17 @@
+//
+// Primitive types, stored in bits 0-7 of SDFObjectGPUData::typeFlags.
+// Kept free of glm so the SIMD kernels can switch on it; the shapes themselves live in SDFPrimitives.
+//
+#pragma once
+
+enum class SDFType : int {
+    SPHERE = 0,         // Ellipsoid: parameters = radii
+    BOX = 1,            // Half size
+    TORUS = 2,          // x = ring radius, y = tube radius, ring in the local xy plane
+    CAPSULE = 3,        // x = radius, y = half length of the segment along local z
+    CYLINDER = 4,       // x = radius, y = half height along local z
+    CONE = 5,           // x = base radius (at z = -y), y = half height, apex on +z
+    PLANE = 6,          // Finite two-sided rectangle in the local xy plane, x / y = half size
+    ROUNDED_BOX = 7,    // Half size, corners rounded by SDFObject::rounding
+    COUNT
+};
@@ -0,0 +1,142 @@
+//
+// GLSL generation for the specialized scene shader
+//
+
+#include "SceneCodegen.h"
+#include <charconv>
+#include <cmath>
+#include <sstream>
+
+using namespace glm;
+
+namespace {
+    const char* const CODEGEN_MARKER = "// @SCENE_CODEGEN@";
+
+    // Shortest text that reads back as the same float, always with a '.' or exponent so GLSL sees a float literal
+    std::string glslFloat(float value) {
+        if (!std::isfinite(value)) value = (value > 0.0f) ? 1e30f : ((value < 0.0f) ? -1e30f : 0.0f);
+        char buffer[32];
+        auto [end, error] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+        std::string text(buffer, end);
+        if (text.find_first_of(".e") == std::string::npos) text += ".0";
+        return text;
+    }
+
+    std::string glslVec3(const vec3& v) {
+        return "vec3(" + glslFloat(v.x) + ", " + glslFloat(v.y) + ", " + glslFloat(v.z) + ")";
+    }
+
+    std::string glslMat3(const vec3& c0, const vec3& c1, const vec3& c2) {
+        return "mat3(" + glslFloat(c0.x) + ", " + glslFloat(c0.y) + ", " + glslFloat(c0.z) + ", "
+                       + glslFloat(c1.x) + ", " + glslFloat(c1.y) + ", " + glslFloat(c1.z) + ", "
+                       + glslFloat(c2.x) + ", " + glslFloat(c2.y) + ", " + glslFloat(c2.z) + ")";
+    }
+
+    bool sameTransform(const SDFObjectGPUData& a, const SDFObjectGPUData& b) {
+        return a.rotation == b.rotation && a.position == b.position;
+    }
+}
+
+int SceneCodegen::getDynamicCount() const {
+    int count = 0;
+    for (uint8_t dynamic : m_dynamic) count += dynamic;
+    return count;
+}
+
+void SceneCodegen::reset() {
+    m_folded.clear();
+    m_dynamic.clear();
+}
+
+bool SceneCodegen::update(const std::vector<SDFObjectGPUData>& objects, bool reordered) {
+    if (reordered || objects.size() != m_folded.size()) {
+        // Indices now belong to other objects, start over with everything folded
+        m_folded = objects;
+        m_dynamic.assign(objects.size(), 0);
+    } else {
+        for (size_t i = 0; i < objects.size(); ++i) {
+            if (!m_dynamic[i] && !sameTransform(objects[i], m_folded[i])) m_dynamic[i] = 1;
+        }
+    }
+
+    std::string code = generate(objects);
+    if (code == m_code) return false;
+    m_code = std::move(code);
+    return true;
+}
+
+std::string SceneCodegen::generate(const std::vector<SDFObjectGPUData>& objects) const {
+    std::ostringstream out;
+    out << "// Generated by SceneCodegen for " << objects.size() << " objects\n";
+    out << "SDFResult mapSceneGenerated(vec3 p, bool computeGradient) {\n";
+    out << "    SDFResult res = SDFResult(MAX_DIST, u_clearColor, -1, false, vec3(0.0), 1.0);\n";
+    if (objects.empty()) {
+        out << "    return res;\n}\n";
+        return out.str();
+    }
+    out << "    float k = u_blendSmoothness;\n";
+    out << "    float blendRadius = k * BLEND_RADIUS_SCALE;\n";
+    out << "    BlendGroup group = openBlendGroup(-1);\n";
+
+    for (size_t i = 0; i < objects.size(); ++i) {
+        const SDFObjectGPUData& object = objects[i];
+        const int type = getObjectType(object);
+        const SDFPrimitive* primitive = SDFPrimitives::find(type);
+        if (!primitive) {
+            out << "    // Object " << i << ": unknown type " << type << ", skipped\n";
+            continue;
+        }
+        const bool dynamic = m_dynamic[i] != 0;
+        const vec4 colorLipschitz = unpackColorLipschitz(object);
+        const vec4 primitiveParams = getPrimitiveParameters(object);
+        const std::string params = "vec4(" + glslVec3(vec3(primitiveParams)) + ", " + glslFloat(primitiveParams.w) + ")";
+
+        out << "    // Object " << i << ": " << primitive->name << (dynamic ? ", transform from the SSBO" : "") << "\n";
+        out << "    {\n";
+        if (dynamic) {
+            out << "        vec4 rotation = sdfBlockInstance.objects[" << i << "].rotation;\n";
+            out << "        vec3 offset = p - sdfBlockInstance.objects[" << i << "].position;\n";
+        } else {
+            out << "        vec3 offset = p - " << glslVec3(object.position) << ";\n";
+        }
+
+        // Same early out as blendObject, with the radius folded
+        const std::string indent = "            ";
+        out << "        if (length(offset) - " << glslFloat(getBoundingRadius(object)) << " <= min(res.dist, group.nearest) + blendRadius) {\n";
+
+        std::string localPoint = "offset";
+        std::string worldGradient = "distGrad.yzw";
+        const vec3 axis = vec3(object.rotation);
+        if (dynamic) {
+            out << indent << "vec3 pLocal = quatRotate(vec4(-rotation.xyz, rotation.w), offset);\n";
+            localPoint = "pLocal";
+            worldGradient = "quatRotate(rotation, distGrad.yzw)";
+        } else if (dot(axis, axis) > 1e-12f) {
+            // Columns of the local -> world rotation; world -> local is its transpose
+            const vec3 c0 = quatRotate(object.rotation, vec3(1.0f, 0.0f, 0.0f));
+            const vec3 c1 = quatRotate(object.rotation, vec3(0.0f, 1.0f, 0.0f));
+            const vec3 c2 = quatRotate(object.rotation, vec3(0.0f, 0.0f, 1.0f));
+            out << indent << "vec3 pLocal = " << glslMat3(vec3(c0.x, c1.x, c2.x), vec3(c0.y, c1.y, c2.y), vec3(c0.z, c1.z, c2.z))
+                << " * offset;\n";
+            localPoint = "pLocal";
+            worldGradient = glslMat3(c0, c1, c2) + " * distGrad.yzw";
+        }
+
+        out << indent << "vec4 distGrad = computeGradient ? sdg" << primitive->glslName << "Local(" << localPoint << ", " << params << ")"
+            << " : vec4(sd" << primitive->glslName << "Local(" << localPoint << ", " << params << "), 0.0, 0.0, 0.0);\n";
+        out << indent << "blendDistance(res, group, " << i << ", " << getBlendGroup(object) << ", distGrad.x, "
+            << worldGradient << ", " << glslVec3(vec3(colorLipschitz)) << ", " << glslFloat(colorLipschitz.w) << ", k);\n";
+        out << "        }\n";
+        out << "    }\n";
+    }
+
+    out << "    closeBlendGroup(res, group, k);\n";
+    out << "    return res;\n}\n";
+    return out.str();
+}
+
+std::string SceneCodegen::insertInto(const std::string& fragmentSource, const std::string& code) {
+    size_t markerPos = fragmentSource.find(CODEGEN_MARKER);
+    if (markerPos == std::string::npos) return "";
+    return fragmentSource.substr(0, markerPos) + code + fragmentSource.substr(markerPos + std::char_traits<char>::length(CODEGEN_MARKER));
+}
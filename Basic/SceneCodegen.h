@@ -0,0 +1,40 @@
+//
+// Scene to GLSL: a mapSceneGenerated() specialized for the current objects, spliced into raymarch.frag.
+// The object loop is unrolled and types, sizes, colors, Lipschitz bounds and bounding spheres become constants.
+// Transforms are folded too, except for objects that moved after they were folded: those read their transform
+// from the SDF SSBO like the generic shader, so dragging an object costs at most one rebuild and the code then
+// stays the same while it keeps moving.
+//
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Basic/SDFObject.h"
+
+class SceneCodegen {
+public:
+    // Injected into both stages of the specialized program (selects mapSceneGenerated in mapScene)
+    static constexpr const char* DEFINES = "#define ASTRAL_GENERATED_SCENE 1\n";
+
+    // Regenerates the code for the objects (same order as the SSBO). reordered = objects were added, removed or
+    // moved to another index since the last call (SDFObjectBuffer::wasStructureChanged). Returns true if the code
+    // changed, i.e. a program built from the previous code no longer matches the scene
+    bool update(const std::vector<SDFObjectGPUData>& objects, bool reordered);
+
+    const std::string& getCode() const { return m_code; }
+    int getObjectCount() const { return static_cast<int>(m_dynamic.size()); }
+    int getDynamicCount() const;
+
+    // Folds every transform again on the next update (e.g. once the user is done arranging the scene)
+    void reset();
+
+    // The fragment source with the code at the "// @SCENE_CODEGEN@" marker. Empty if the marker is missing
+    static std::string insertInto(const std::string& fragmentSource, const std::string& code);
+
+private:
+    std::string generate(const std::vector<SDFObjectGPUData>& objects) const;
+
+    std::vector<SDFObjectGPUData> m_folded; // Transform each object had when it was folded
+    std::vector<uint8_t> m_dynamic;         // 1 = transform read from the SSBO
+    std::string m_code;
+};
@@ -0,0 +1,192 @@
+//
+// CPU binning of objects into screen tiles
+//
+
+#include "TileBinner.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace glm;
+
+static bool isEmptyBox(const vec3& boxMin, const vec3& boxMax) {
+    return boxMin.x > boxMax.x || boxMin.y > boxMax.y || boxMin.z > boxMax.z;
+}
+
+void TileBinner::bin(const std::vector<SDFObjectGPUData>& objects, const TileCamera& camera, float blendSmoothness, int tileSize) {
+    m_tileSize = std::max(1, tileSize);
+    m_tilesX = (std::max(1, camera.width) + m_tileSize - 1) / m_tileSize;
+    m_tilesY = (std::max(1, camera.height) + m_tileSize - 1) / m_tileSize;
+    const int tileCount = m_tilesX * m_tilesY;
+    const int objectCount = static_cast<int>(objects.size());
+
+    const float tanHalfFov = std::tan(radians(camera.fov * 0.5f));
+    const float aspectRatio = static_cast<float>(camera.width) / static_cast<float>(std::max(1, camera.height));
+    const mat3 worldToView = transpose(camera.basis);
+    const float nearDepth = 1e-4f;
+
+    // 1. Tile rectangle covered by each object
+    m_objectTiles.resize(objectCount);
+    for (int i = 0; i < objectCount; ++i) {
+        vec3 boundsMin, boundsMax;
+        getWorldBounds(objects[i], boundsMin, boundsMax);
+        // Grown by the blend radius: closer than that the object still weighs in on its neighbours' blend
+        boundsMin -= vec3(blendSmoothness * sdfkernels::BLEND_RADIUS_SCALE);
+        boundsMax += vec3(blendSmoothness * sdfkernels::BLEND_RADIUS_SCALE);
+
+        vec2 screenMin(1e30f), screenMax(-1e30f);
+        int cornersInFront = 0;
+        bool straddlesCamera = false;
+        for (int corner = 0; corner < 8; ++corner) {
+            vec3 world((corner & 1) ? boundsMax.x : boundsMin.x,
+                       (corner & 2) ? boundsMax.y : boundsMin.y,
+                       (corner & 4) ? boundsMax.z : boundsMin.z);
+            vec3 view = worldToView * (world - camera.position);
+            float depth = -view.z;
+            if (depth <= nearDepth) { straddlesCamera = true; continue; }
+            ++cornersInFront;
+
+            // Inverse of getRayDir: view direction -> fragCoordScreen -> pixels
+            vec2 ndc(view.x / (depth * aspectRatio * tanHalfFov), view.y / (depth * tanHalfFov));
+            vec2 pixel = (ndc * 0.5f + 0.5f) * vec2(static_cast<float>(camera.width), static_cast<float>(camera.height));
+            screenMin = min(screenMin, pixel);
+            screenMax = max(screenMax, pixel);
+        }
+
+        ivec4& rect = m_objectTiles[i];
+        if (cornersInFront == 0) {
+            rect = ivec4(1, 1, 0, 0); // Entirely behind the camera
+        } else if (straddlesCamera) {
+            rect = ivec4(0, 0, m_tilesX - 1, m_tilesY - 1); // Projection is unbounded, keep it everywhere
+        } else if (screenMax.x < 0.0f || screenMax.y < 0.0f ||
+                   screenMin.x >= static_cast<float>(camera.width) || screenMin.y >= static_cast<float>(camera.height)) {
+            rect = ivec4(1, 1, 0, 0); // Off screen
+        } else {
+            rect.x = std::clamp(static_cast<int>(std::floor(screenMin.x)) / m_tileSize, 0, m_tilesX - 1);
+            rect.y = std::clamp(static_cast<int>(std::floor(screenMin.y)) / m_tileSize, 0, m_tilesY - 1);
+            rect.z = std::clamp(static_cast<int>(std::floor(screenMax.x)) / m_tileSize, 0, m_tilesX - 1);
+            rect.w = std::clamp(static_cast<int>(std::floor(screenMax.y)) / m_tileSize, 0, m_tilesY - 1);
+        }
+    }
+
+    // 2. Count per tile, prefix sum into the headers
+    m_counts.assign(tileCount, 0);
+    for (const ivec4& rect : m_objectTiles) {
+        for (int ty = rect.y; ty <= rect.w; ++ty)
+            for (int tx = rect.x; tx <= rect.z; ++tx)
+                ++m_counts[ty * m_tilesX + tx];
+    }
+
+    uint32_t offset = 2u * static_cast<uint32_t>(tileCount);
+    m_data.resize(2 * static_cast<size_t>(tileCount));
+    for (int tile = 0; tile < tileCount; ++tile) {
+        m_data[2 * tile] = offset;
+        m_data[2 * tile + 1] = 0;
+        offset += m_counts[tile];
+    }
+    m_data.resize(offset);
+
+    // 3. Fill, objects in increasing order so every list keeps the smin chain order
+    for (int i = 0; i < objectCount; ++i) {
+        const ivec4& rect = m_objectTiles[i];
+        for (int ty = rect.y; ty <= rect.w; ++ty) {
+            for (int tx = rect.x; tx <= rect.z; ++tx) {
+                const int tile = ty * m_tilesX + tx;
+                m_data[m_data[2 * tile] + m_data[2 * tile + 1]++] = static_cast<uint32_t>(i);
+            }
+        }
+    }
+}
+
+void TileBinner::binCSG(const SDFEvaluator& evaluator, const TileCamera& camera, const vec3& sceneBoundsMin,
+                        const vec3& sceneBoundsMax, int tileSize) {
+    m_tileSize = std::max(1, tileSize);
+    m_tilesX = (std::max(1, camera.width) + m_tileSize - 1) / m_tileSize;
+    m_tilesY = (std::max(1, camera.height) + m_tileSize - 1) / m_tileSize;
+    const int tileCount = m_tilesX * m_tilesY;
+
+    // Every tile starts empty: tiles whose rays never enter the scene bounds keep a zero length tape
+    m_data.assign(2 * static_cast<size_t>(tileCount), 0);
+    const std::vector<CSGInstruction>& program = evaluator.getCSGProgram();
+    if (program.empty() || isEmptyBox(sceneBoundsMin, sceneBoundsMax)) return;
+
+    TapeFrustum frustum;
+    frustum.camera = camera;
+    frustum.tanHalfFov = std::tan(radians(camera.fov * 0.5f));
+    frustum.aspectRatio = static_cast<float>(camera.width) / static_cast<float>(std::max(1, camera.height));
+    frustum.boundsMin = sceneBoundsMin;
+    frustum.boundsMax = sceneBoundsMax;
+
+    // View depth range of the scene bounds: every point a ray marches through lies inside it
+    const mat3 worldToView = transpose(camera.basis);
+    frustum.nearDepth = 1e30f;
+    frustum.farDepth = -1e30f;
+    for (int corner = 0; corner < 8; ++corner) {
+        vec3 world((corner & 1) ? sceneBoundsMax.x : sceneBoundsMin.x,
+                   (corner & 2) ? sceneBoundsMax.y : sceneBoundsMin.y,
+                   (corner & 4) ? sceneBoundsMax.z : sceneBoundsMin.z);
+        float depth = -(worldToView * (world - camera.position)).z;
+        frustum.nearDepth = std::min(frustum.nearDepth, depth);
+        frustum.farDepth = std::max(frustum.farDepth, depth);
+    }
+    frustum.nearDepth = std::max(frustum.nearDepth, 1e-4f);
+    if (frustum.farDepth <= frustum.nearDepth) return; // Behind the camera
+    frustum.margin = 1e-3f * frustum.farDepth;         // calcNormal steps by t * 0.0005
+
+    int levels = 1;
+    while ((1 << (levels - 1)) < std::max(m_tilesX, m_tilesY)) ++levels;
+    m_levelTapes.resize(levels + 1); // Sized up front, pruneTiles holds references into it
+    pruneTiles(evaluator, frustum, ivec4(0, 0, m_tilesX - 1, m_tilesY - 1), program, 0);
+}
+
+void TileBinner::pruneTiles(const SDFEvaluator& evaluator, const TapeFrustum& frustum, ivec4 tiles,
+                            const std::vector<CSGInstruction>& tape, int level) {
+    const TileCamera& camera = frustum.camera;
+    const vec2 pixelMin = vec2(tiles.x, tiles.y) * static_cast<float>(m_tileSize);
+    const vec2 pixelMax = min(vec2(tiles.z + 1, tiles.w + 1) * static_cast<float>(m_tileSize),
+                              vec2(static_cast<float>(camera.width), static_cast<float>(camera.height)));
+
+    // Box around the slice of the rectangle's frustum between the near and far depth (its 8 corners, same
+    // mapping as getRayDir), cut down to the scene bounds
+    vec3 boxMin(1e30f), boxMax(-1e30f);
+    for (int corner = 0; corner < 8; ++corner) {
+        vec2 pixel((corner & 1) ? pixelMax.x : pixelMin.x, (corner & 2) ? pixelMax.y : pixelMin.y);
+        float depth = (corner & 4) ? frustum.farDepth : frustum.nearDepth;
+        vec2 ndc = pixel / vec2(static_cast<float>(camera.width), static_cast<float>(camera.height)) * 2.0f - 1.0f;
+        vec3 view(ndc.x * frustum.aspectRatio * frustum.tanHalfFov * depth, ndc.y * frustum.tanHalfFov * depth, -depth);
+        vec3 world = camera.position + camera.basis * view;
+        boxMin = min(boxMin, world);
+        boxMax = max(boxMax, world);
+    }
+    boxMin = max(boxMin - vec3(frustum.margin), frustum.boundsMin);
+    boxMax = min(boxMax + vec3(frustum.margin), frustum.boundsMax);
+    if (isEmptyBox(boxMin, boxMax)) return; // These rays miss the scene bounds
+
+    std::vector<CSGInstruction>& pruned = m_levelTapes[level];
+    evaluator.pruneCSG(tape, boxMin, boxMax, pruned);
+
+    if (tiles.x == tiles.z && tiles.y == tiles.w) {
+        const int tile = tiles.y * m_tilesX + tiles.x;
+        m_data[2 * tile] = static_cast<uint32_t>(m_data.size());
+        m_data[2 * tile + 1] = static_cast<uint32_t>(pruned.size());
+        for (const CSGInstruction& instruction : pruned) {
+            uint32_t smoothnessBits;
+            std::memcpy(&smoothnessBits, &instruction.smoothness, sizeof(smoothnessBits));
+            m_data.push_back(instruction.opcode);
+            m_data.push_back(smoothnessBits);
+        }
+        return;
+    }
+
+    // Quarters (halves once a side is a single tile)
+    const int midX = (tiles.x + tiles.z) / 2;
+    const int midY = (tiles.y + tiles.w) / 2;
+    const ivec4 quarters[4] = {
+        ivec4(tiles.x, tiles.y, midX, midY), ivec4(midX + 1, tiles.y, tiles.z, midY),
+        ivec4(tiles.x, midY + 1, midX, tiles.w), ivec4(midX + 1, midY + 1, tiles.z, tiles.w)
+    };
+    for (const ivec4& quarter : quarters) {
+        if (quarter.x > quarter.z || quarter.y > quarter.w) continue;
+        pruneTiles(evaluator, frustum, quarter, pruned, level + 1);
+    }
+}
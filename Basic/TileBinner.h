@@ -0,0 +1,75 @@
+//
+// Screen-tile object culling: projects every object's world AABB (grown by the blend radius) onto the screen
+// and lists, per tile, the objects whose projection touches it. A pixel's ray can only hit (or blend with)
+// objects of its own tile, so mapTheWorld iterates that list instead of every object.
+// Scenes with a CSG program get a pruned copy of the program per tile instead (binCSG).
+//
+#pragma once
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+#include "Basic/SDFObject.h"
+#include "Basic/SDFEvaluator.h"
+
+// Same camera inputs as getRayDir in raymarch.frag
+struct TileCamera {
+    glm::vec3 position = glm::vec3(0.0f);
+    glm::mat3 basis = glm::mat3(1.0f); // Right, Up, Back (the view direction is -basis[2])
+    float fov = 45.0f;                 // Vertical, degrees
+    int width = 1;
+    int height = 1;
+};
+
+class TileBinner {
+public:
+    static constexpr int DEFAULT_TILE_SIZE = 16;
+
+    // Rebuilds the lists from the objects as uploaded (SDFObjectBuffer::getData), so the lists hold buffer indices.
+    // Tiles are numbered row by row from the bottom-left, like gl_FragCoord
+    void bin(const std::vector<SDFObjectGPUData>& objects, const TileCamera& camera, float blendSmoothness,
+             int tileSize = DEFAULT_TILE_SIZE);
+
+    // Per-tile CSG tapes: the part of the tile's frustum inside the scene bounds is boxed and the evaluator's
+    // program pruned over it (SDFEvaluator::pruneCSG). Tile groups are pruned first, quadtree style, so a tile
+    // starts from its parent's already short tape
+    void binCSG(const SDFEvaluator& evaluator, const TileCamera& camera, const glm::vec3& sceneBoundsMin,
+                const glm::vec3& sceneBoundsMax, int tileSize = DEFAULT_TILE_SIZE);
+
+    // Layout of TileBlock in raymarch.frag: tileCount (offset, count) pairs, then the object indices.
+    // Offsets index into the same array, each list is in increasing object order.
+    // After binCSG count is the tape length and every instruction takes two entries (opcode, smoothness bits)
+    const std::vector<uint32_t>& getData() const { return m_data; }
+
+    int getTileSize() const { return m_tileSize; }
+    int getTilesX() const { return m_tilesX; }
+    int getTilesY() const { return m_tilesY; }
+    // Sum of all list lengths (two per tape instruction after binCSG), compare with tiles * objects to see
+    // how much work is culled
+    int getTotalEntries() const { return static_cast<int>(m_data.size()) - 2 * m_tilesX * m_tilesY; }
+
+private:
+    int m_tileSize = DEFAULT_TILE_SIZE;
+    int m_tilesX = 0;
+    int m_tilesY = 0;
+    std::vector<uint32_t> m_data;
+
+    // Scratch: tile rectangle per object (x0, y0, x1, y1 inclusive, x0 > x1 when off screen)
+    std::vector<glm::ivec4> m_objectTiles;
+    std::vector<uint32_t> m_counts;
+
+    // binCSG: the view volume every tile box is cut from
+    struct TapeFrustum {
+        TileCamera camera;
+        float tanHalfFov;
+        float aspectRatio;
+        float nearDepth;        // View depth range of the scene bounds
+        float farDepth;
+        glm::vec3 boundsMin;    // Scene bounds
+        glm::vec3 boundsMax;
+        float margin;           // Tile boxes grow by this, for the normal's finite differences
+    };
+    // Prunes 'tape' over the tile rectangle (x0, y0, x1, y1 inclusive) and recurses into its quarters
+    void pruneTiles(const SDFEvaluator& evaluator, const TapeFrustum& frustum, glm::ivec4 tiles,
+                    const std::vector<CSGInstruction>& tape, int level);
+    std::vector<std::vector<CSGInstruction>> m_levelTapes;
+};
@@ -93,6 +93,7 @@ void TransformManager::cancelTransform(SDFObject* objPtr) {
     if (cancelledMode == TransformMode::SCALING) {
         objPtr->parameters = initialParameters;
     }
+    objPtr->markDirty();
 }
 
 TransformManager::InputResult TransformManager::update(std::vector<SDFObject> &objects, int &selectedObjectId) {
@@ -301,6 +302,7 @@ void TransformManager::applyModalTranslation(SDFObject* objPtr, double totalDelt
 
     // Apply the final calculated delta to the initial position
     objPtr->position = initialPosition + finalDelta;
+    objPtr->markDirty();
 }
 
 void TransformManager::applyModalRotation(SDFObject* objPtr, double totalDeltaX, double totalDeltaY, int display_w, int display_h) {
@@ -338,6 +340,7 @@ void TransformManager::applyModalRotation(SDFObject* objPtr, double totalDeltaX,
     } else {
         objPtr->rotation = initialRotation; // No rotation if axis is invalid
     }
+    objPtr->markDirty();
 }
 
 void TransformManager::applyModalScaling(SDFObject *objPtr, double totalDeltaX, double totalDeltaY, int display_w, int display_h) {
@@ -383,4 +386,5 @@ void TransformManager::applyModalScaling(SDFObject *objPtr, double totalDeltaX,
 
     // Ensure parameters don't become zero or negative (safety clamp)
     objPtr->parameters = max(objPtr->parameters, glm::vec3(1e-6f));
+    objPtr->markDirty();
 }
\ No newline at end of file
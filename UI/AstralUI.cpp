@@ -5,6 +5,7 @@
 #include "AstralUI.h"
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include <algorithm>
 #include <numeric>
 #include <cmath>
 #include <imgui_impl_opengl3.h>
@@ -162,24 +163,34 @@ void AstralUI::renderMainPanel(float& fovRef, size_t ramBytes,
         ColorEdit3("Clear Color", m_params.clearColor);
         SliderFloat("Flied of View", &fovRef, 10.0f, 120.0f);
         SliderFloat("Blend Smoothness", &m_params.blendSmoothness, 0.001f, 5.0f);
+        Checkbox("Render On Demand", &m_params.renderOnDemand);
+        SliderInt("FPS Cap (0 = off)", &m_params.fpsCap, 0, 240);
+        Checkbox("Hover Highlight", &m_params.hoverHighlight);
+
+        // Step budget vs precision
+        if (BeginCombo("Quality", getQualitySettings(m_params.quality).name)) {
+            for (int i = 0; i <= static_cast<int>(QualityPreset::REFERENCE); ++i) {
+                QualityPreset preset = static_cast<QualityPreset>(i);
+                QualitySettings quality = getQualitySettings(preset);
+                if (Selectable(quality.name, m_params.quality == preset)) m_params.quality = preset;
+                if (IsItemHovered()) SetTooltip("%d steps, hit epsilon %.1f px", quality.maxSteps, quality.coneScale);
+            }
+            EndCombo();
+        }
     }
 
     Separator();
 
     if (CollapsingHeader("Scene Hierarchy", ImGuiTreeNodeFlags_DefaultOpen)) {
-        // Button to add new objects
-        if (Button("Add Sphere")) {
-            SDFObject newObj(nextSdfId++);
-            newObj.type = SDFType::SPHERE;
-            newObj.position = glm::vec3(0.0f, 0.0f, -1.0f);
-            objects.push_back(newObj);
-        }
-        SameLine();
-        if (Button("Add Box")) {
-            SDFObject newObj(nextSdfId++);
-            newObj.type = SDFType::BOX;
-            newObj.position = glm::vec3(0.0f, 0.0f, -1.0f);
-            objects.push_back(newObj);
+        // Button to add new objects, one per registered primitive
+        for (int type = 0; type < static_cast<int>(SDFType::COUNT); ++type) {
+            const SDFPrimitive& primitive = SDFPrimitives::get(static_cast<SDFType>(type));
+            if (type % 4 != 0) SameLine();
+            if (Button((std::string("Add ") + primitive.name).c_str())) {
+                SDFObject newObj(nextSdfId++, primitive.type);
+                newObj.position = glm::vec3(0.0f, 0.0f, -1.0f);
+                objects.push_back(newObj);
+            }
         }
     }
 
@@ -266,21 +277,53 @@ void AstralUI::renderMainPanel(float& fovRef, size_t ramBytes,
 
             // Edit Transform
             Text("Transform");
-            DragFloat3("Position", value_ptr(selectedObjPtr->position), 0.1f);
-            DragFloat3("Rotation", value_ptr(selectedObjPtr->rotation), 1.0f);
+            // Edits flag the object so only it is re-uploaded to the GPU
+            if (DragFloat3("Position", value_ptr(selectedObjPtr->position), 0.1f)) selectedObjPtr->markDirty();
+            if (DragFloat3("Rotation", value_ptr(selectedObjPtr->rotation), 1.0f)) selectedObjPtr->markDirty();
             Separator();
 
             // Edit Color
             Text("Appearance");
-            ColorEdit3("Color", value_ptr(selectedObjPtr->color));
+            if (ColorEdit3("Color", value_ptr(selectedObjPtr->color))) selectedObjPtr->markDirty();
+            // Objects blend smoothly only with their own group, groups meet with a hard edge
+            if (InputInt("Blend Group", &selectedObjPtr->blendGroup)) {
+                selectedObjPtr->blendGroup = std::clamp(selectedObjPtr->blendGroup, 0, 255);
+                selectedObjPtr->markDirty();
+            }
             Separator();
 
             // Edit Type-Specific Parameters
             Text("Parameters");
-            if (selectedObjPtr->type == SDFType::SPHERE) {
-                DragFloat3("radius (X/Y/Z)", value_ptr(selectedObjPtr->parameters), 0.01f, 0.001f, 100.0f);
-            } else if (selectedObjPtr->type == SDFType::BOX) {
-                DragFloat3("Half Size", value_ptr(selectedObjPtr->parameters), 0.01f, 0.001f, 100.0f);
+            const SDFPrimitive& primitive = SDFPrimitives::get(selectedObjPtr->type);
+            float* parameters = value_ptr(selectedObjPtr->parameters);
+            bool parametersChanged = (primitive.parameterCount == 2)
+                ? DragFloat2(primitive.parameterLabel, parameters, 0.01f, 0.001f, 100.0f)
+                : DragFloat3(primitive.parameterLabel, parameters, 0.01f, 0.001f, 100.0f);
+            if (parametersChanged) selectedObjPtr->markDirty();
+            if (selectedObjPtr->type == SDFType::ROUNDED_BOX) {
+                if (SliderFloat("Rounding", &selectedObjPtr->rounding, 0.0f, 1.0f)) selectedObjPtr->markDirty();
+            }
+            Separator();
+
+            // How this object combines with the shapes before it (its join in the scene CSG tree)
+            Text("Composition");
+            CSGTree::Node* join = m_csgTree ? m_csgTree->findJoinOf(selectedObjPtr->id) : nullptr;
+            if (join) {
+                int operation = static_cast<int>(join->operation);
+                if (Combo("Operation", &operation, "Union\0Subtract\0Intersect\0")) {
+                    join->operation = static_cast<CSGOperation>(operation);
+                    m_csgTree->markChanged();
+                }
+                bool sceneSmoothness = join->smoothness < 0.0f;
+                if (Checkbox("Scene Blend Smoothness", &sceneSmoothness)) {
+                    join->smoothness = sceneSmoothness ? -1.0f : m_params.blendSmoothness;
+                    m_csgTree->markChanged();
+                }
+                if (!sceneSmoothness && SliderFloat("Smoothness", &join->smoothness, 0.0f, 5.0f)) {
+                    m_csgTree->markChanged();
+                }
+            } else {
+                TextDisabled("First shape, the others combine onto it");
             }
 
         } else {
@@ -299,6 +342,43 @@ void AstralUI::renderMainPanel(float& fovRef, size_t ramBytes,
         RadioButton("Hit/Miss", &m_selectedDebugMode, 2);SameLine();
         RadioButton("Normals", &m_selectedDebugMode, 3);SameLine();
         RadioButton("Object ID", &m_selectedDebugMode, 4);
+        Checkbox("Lighting", &m_params.lighting); SameLine();
+        Checkbox("Selection Highlight", &m_params.selectionHighlight);
+        Checkbox("Compare Steps (left: original march)", &m_params.stepsCompare);
+        SliderFloat("Over-relaxation", &m_params.relaxation, 1.0f, 1.9f, "%.2f");
+
+        Text("Object Culling");
+        int cullingMode = static_cast<int>(m_params.cullingMode);
+        RadioButton("None", &cullingMode, static_cast<int>(CullingMode::NONE)); SameLine();
+        RadioButton("BVH", &cullingMode, static_cast<int>(CullingMode::BVH)); SameLine();
+        RadioButton("Screen Tiles", &cullingMode, static_cast<int>(CullingMode::TILES));
+        m_params.cullingMode = static_cast<CullingMode>(cullingMode);
+        Checkbox("Specialized Scene Shader", &m_params.generatedScene);
+        if (!m_sceneShaderStatus.empty()) TextDisabled("%s", m_sceneShaderStatus.c_str());
+        Checkbox("Optimize CSG", &m_params.optimizeCSG);
+        if (!m_csgStatus.empty()) TextDisabled("%s", m_csgStatus.c_str());
+        Checkbox("Shader Variants", &m_params.shaderVariants); SameLine();
+        if (Button("Prewarm All Variants")) {
+            m_prewarmRequested = true;
+        }
+        if (!m_variantStatus.empty()) TextDisabled("%s", m_variantStatus.c_str());
+
+        Text("Normals");
+        int normalMethod = static_cast<int>(m_params.normalMethod);
+        RadioButton("Analytic", &normalMethod, static_cast<int>(NormalMethod::ANALYTIC)); SameLine();
+        RadioButton("Finite Difference", &normalMethod, static_cast<int>(NormalMethod::FINITE_DIFFERENCE));
+        m_params.normalMethod = static_cast<NormalMethod>(normalMethod);
+
+        Text("Picking");
+        int pickingMode = static_cast<int>(m_params.pickingMode);
+        RadioButton("CPU Ray Cast", &pickingMode, static_cast<int>(PickingMode::CPU_RAYCAST)); SameLine();
+        RadioButton("GPU Readback", &pickingMode, static_cast<int>(PickingMode::GPU_READBACK));
+        m_params.pickingMode = static_cast<PickingMode>(pickingMode);
+
+        // Writes the GPU frame and a CPU render of the same view for comparison
+        if (Button("Save Frame (GPU + CPU)")) {
+            m_frameCaptureRequested = true;
+        }
     }
 
     Separator(); // Separate section
@@ -315,6 +395,34 @@ void AstralUI::renderMainPanel(float& fovRef, size_t ramBytes,
         Text("Frame Time: %.3f ms", io.Framerate > 0 ? (1000.0f / io.Framerate) : 0.0f);
         // --- GPU Timing ---
         Separator();
+        if (m_profiler) {
+            Text("GPU Timing (ms, last %d frames)", GPUProfiler::HISTORY_SIZE);
+            if (BeginTable("gpu_timing", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+                TableSetupColumn("Pass");
+                TableSetupColumn("Avg");
+                TableSetupColumn("p50");
+                TableSetupColumn("p95");
+                TableSetupColumn("p99");
+                TableHeadersRow();
+                for (int pass = 0; pass < GPUProfiler::PASS_COUNT; ++pass) {
+                    GPUProfiler::PassStats stats = m_profiler->getStats(static_cast<GPUProfiler::Pass>(pass));
+                    TableNextRow();
+                    TableNextColumn(); Text("%s", GPUProfiler::getPassName(static_cast<GPUProfiler::Pass>(pass)));
+                    if (stats.sampleCount == 0) {
+                        TableNextColumn(); TextDisabled("-");
+                        continue;
+                    }
+                    TableNextColumn(); Text("%.3f", stats.averageMs);
+                    TableNextColumn(); Text("%.3f", stats.p50Ms);
+                    TableNextColumn(); Text("%.3f", stats.p95Ms);
+                    TableNextColumn(); Text("%.3f", stats.p99Ms);
+                }
+                EndTable();
+            }
+            if (m_profiler->getDroppedFrames() > 0) {
+                TextDisabled("Results not ready in time: %d frames", m_profiler->getDroppedFrames());
+            }
+        }
 
         // Plot frame times
         PlotLines("Frame Times", m_frameTimes, IM_ARRAYSIZE(m_frameTimes), m_frameTimeIndex,
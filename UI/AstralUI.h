@@ -6,9 +6,31 @@
 #include <vector>
 #include "imgui_impl_glfw.h"
 #include "Basic/SDFObject.h"
+#include "utilities/GPUProfiler.h"
+#include "Basic/RenderQuality.h"
+#include "Basic/CSGTree.h"
 
 struct GLFWindow;
 
+// Where click / hover picking gets the object under the cursor
+enum class PickingMode : int {
+    CPU_RAYCAST = 0,    // One ray marched on the CPU, no GPU readback
+    GPU_READBACK = 1    // Async read of the picking texture (PBO ring)
+};
+
+// How mapTheWorld narrows down the objects it evaluates (u_cullingMode in raymarch.frag)
+enum class CullingMode : int {
+    NONE = 0,   // Every object at every step
+    BVH = 1,    // Objects near the sample point, from the object BVH
+    TILES = 2   // Objects whose screen bounds touch the pixel's tile
+};
+
+// How calcNormal gets the surface normal (u_normalMethod in raymarch.frag)
+enum class NormalMethod : int {
+    ANALYTIC = 0,           // Gradient from one scene evaluation
+    FINITE_DIFFERENCE = 1   // Central differences, six scene evaluations (validation)
+};
+
 
 // Structure to hold all the parameters controlled by UI
 struct RenderParams {
@@ -30,6 +52,28 @@ struct RenderParams {
 
     float blendSmoothness = 0.1f; // Controls 'k' in smin
 
+    CullingMode cullingMode = CullingMode::TILES;
+    bool generatedScene = false; // Draw with a shader generated for the current objects once it is built
+    bool shaderVariants = true;  // Draw with a variant that has the modes below compiled in (ShaderPermutations.h)
+    bool optimizeCSG = true;     // Simplify the composition tree before it is compiled (CSGOptimizer.h)
+
+    // Shading
+    bool lighting = true;            // Off: unlit base colors
+    bool selectionHighlight = true;  // Off: no selection / hover tint
+    NormalMethod normalMethod = NormalMethod::ANALYTIC;
+
+    // Sphere tracing
+    float relaxation = 1.5f;    // Over-relaxation factor, 1 = plain Lipschitz steps
+    bool stepsCompare = false;  // Steps view: left half with the original march
+    QualityPreset quality = QualityPreset::BALANCED; // Step budget and cone hit epsilon
+
+    // Frame pacing
+    bool renderOnDemand = true; // Only raymarch when the scene, camera or settings changed
+    int fpsCap = 0;             // 0 = uncapped
+
+    bool hoverHighlight = false; // Tint the object under the cursor
+    PickingMode pickingMode = PickingMode::CPU_RAYCAST;
+
 };
 
 class AstralUI {
@@ -50,6 +94,23 @@ public:
     const RenderParams& getParams() const { return m_params; }
     int getDebugMode() const { return m_selectedDebugMode; } // Getter
 
+    // Source of the GPU Timing table in the Info panel (optional)
+    void setProfiler(const GPUProfiler* profiler) { m_profiler = profiler; }
+
+    // Which scene shader is drawing, shown under the Specialized Scene Shader checkbox
+    // Tree edited by the Composition section of the Inspector (optional)
+    void setCSGTree(CSGTree* tree) { m_csgTree = tree; }
+
+    void setSceneShaderStatus(const std::string& status) { m_sceneShaderStatus = status; }
+    void setCSGStatus(const std::string& status) { m_csgStatus = status; }
+    void setVariantStatus(const std::string& status) { m_variantStatus = status; }
+
+    // True once after "Prewarm All Variants" was pressed
+    bool consumePrewarmRequest() { bool requested = m_prewarmRequested; m_prewarmRequested = false; return requested; }
+
+    // True once after "Save Frame" was pressed
+    bool consumeFrameCaptureRequest() { bool requested = m_frameCaptureRequested; m_frameCaptureRequested = false; return requested; }
+
 private:
 
     // Initialize ImGui context and style
@@ -64,6 +125,13 @@ private:
     RenderParams m_params;
 
     int m_selectedDebugMode = 0; // Add a member variable with default
+    bool m_frameCaptureRequested = false;
+    const GPUProfiler* m_profiler = nullptr;
+    CSGTree* m_csgTree = nullptr;
+    std::string m_sceneShaderStatus;
+    std::string m_csgStatus;
+    std::string m_variantStatus;
+    bool m_prewarmRequested = false;
 
     // UI state
     bool m_showDemoWindow = false;
@@ -0,0 +1,242 @@
+//
+// Headless renderer: raymarches the default scene on the CPU and writes a PPM/PFM image.
+// Runs without a window or GL context, for render boxes and CI machines with no GPU.
+//
+#define GLM_ENABLE_EXPERIMENTAL
+
+#include <glm/glm.hpp>
+#include <glm/gtx/quaternion.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Basic/SDFObject.h"
+#include "Basic/SDFEvaluator.h"
+#include "Basic/CPURaymarcher.h"
+#include "Basic/RenderQuality.h"
+#include "Basic/SDFBVH.h"
+#include "Basic/CSGTree.h"
+#include "Basic/CSGOptimizer.h"
+#include "utilities/ThreadPool.h"
+#include "utilities/utility.h"
+
+using namespace glm;
+using namespace std;
+
+static void printUsage() {
+    cout << "Usage: AstralHeadless [options]\n"
+         << "  --out <file>        Output image, .ppm (8-bit) or .pfm (float)  [astral.ppm]\n"
+         << "  --width <px>        Image width   [1920]\n"
+         << "  --height <px>       Image height  [1080]\n"
+         << "  --debug <mode>      0 basic, 1 steps, 2 hit/miss, 3 normals, 4 object ID  [0]\n"
+         << "  --fov <deg>         Vertical field of view  [45]\n"
+         << "  --blend <k>         Blend smoothness  [0.1]\n"
+         << "  --selected <index>  Highlight an object index  [-1]\n"
+         << "  --threads <n>       Worker threads, 0 = all  [0]\n"
+         << "  --tile <px>         Tile size  [32]\n"
+         << "  --isa <name>        scalar, avx2 or avx512 (clamped to the CPU)  [best]\n"
+         << "  --normals <method>  analytic or fd (finite difference)  [analytic]\n"
+         << "  --relax <w>         Sphere tracing over-relaxation, 1 = off  [1.5]\n"
+         << "  --compare-steps     Steps view: left half with the original march\n"
+         << "  --quality <name>    Draft, Balanced, High or Reference  [Balanced]\n"
+         << "  --unlit             Base colors without lighting\n"
+         << "  --no-highlight      No selection / hover tint\n"
+         << "  --csg <op>          How the box joins the sphere: union, subtract or intersect  [union]\n"
+         << "  --no-csg-opt        Compile the composition without CSGOptimizer\n"
+         << "  --primitives        One object of every primitive type instead of the default scene\n"
+         << "  --pick <x> <y>      Print the object index under a pixel (top-left origin) and exit\n"
+         << "  --check-pruning     Add an elongated ellipsoid, compare the CSG program with its pruned tapes over a\n"
+         << "                      nested grid of boxes and exit\n";
+}
+
+int main(int argc, char** argv) {
+    string outPath = "astral.ppm";
+    CPURenderSettings settings;
+    float blendSmoothness = 0.1f;       // AstralUI default
+    unsigned threadCount = 0;
+    string isaName;
+    int pickX = -1, pickY = -1;
+    string csgOperation = "union";
+    bool optimizeCSG = true;
+    bool primitiveScene = false;
+    bool checkPruning = false;
+    settings.clearColor = vec3(0.1f, 0.1f, 0.15f); // AstralUI default
+
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        bool hasValue = (i + 1 < argc);
+        if (arg == "--help" || arg == "-h") { printUsage(); return 0; }
+        else if (arg == "--out" && hasValue) outPath = argv[++i];
+        else if (arg == "--width" && hasValue) settings.width = atoi(argv[++i]);
+        else if (arg == "--height" && hasValue) settings.height = atoi(argv[++i]);
+        else if (arg == "--debug" && hasValue) settings.debugMode = atoi(argv[++i]);
+        else if (arg == "--fov" && hasValue) settings.fov = static_cast<float>(atof(argv[++i]));
+        else if (arg == "--blend" && hasValue) blendSmoothness = static_cast<float>(atof(argv[++i]));
+        else if (arg == "--selected" && hasValue) settings.selectedIndex = atoi(argv[++i]);
+        else if (arg == "--threads" && hasValue) threadCount = static_cast<unsigned>(atoi(argv[++i]));
+        else if (arg == "--tile" && hasValue) settings.tileSize = atoi(argv[++i]);
+        else if (arg == "--isa" && hasValue) isaName = argv[++i];
+        else if (arg == "--relax" && hasValue) settings.relaxation = static_cast<float>(atof(argv[++i]));
+        else if (arg == "--compare-steps") settings.stepsCompare = true;
+        else if (arg == "--unlit") settings.lighting = false;
+        else if (arg == "--no-highlight") settings.selectionHighlight = false;
+        else if (arg == "--csg" && hasValue) csgOperation = argv[++i];
+        else if (arg == "--no-csg-opt") optimizeCSG = false;
+        else if (arg == "--primitives") primitiveScene = true;
+        else if (arg == "--check-pruning") checkPruning = true;
+        else if (arg == "--quality" && hasValue) {
+            QualityPreset preset;
+            if (!findQualityPreset(argv[++i], preset)) { cerr << "Unknown quality preset: " << argv[i] << endl; return -1; }
+            settings.maxSteps = getQualitySettings(preset).maxSteps;
+            settings.coneScale = getQualitySettings(preset).coneScale;
+        }
+        else if (arg == "--normals" && hasValue) settings.normalMethod = (string(argv[++i]) == "fd") ? 1 : 0;
+        else if (arg == "--pick" && i + 2 < argc) { pickX = atoi(argv[++i]); pickY = atoi(argv[++i]); }
+        else { cerr << "Unknown or incomplete option: " << arg << endl; printUsage(); return -1; }
+    }
+    if (settings.width <= 0 || settings.height <= 0) { cerr << "Invalid image size." << endl; return -1; }
+
+    // --- Scene (same as the editor start-up) ---
+    vector<SDFObject> sdfObjects;
+    int nextSdfId = 0;
+    if (primitiveScene) createPrimitiveScene(sdfObjects, nextSdfId);
+    else createDefaultScene(sdfObjects, nextSdfId);
+    if (checkPruning) {
+        // An elongated ellipsoid, whose distance is not exact and changes up to ~6x faster than the distance moved.
+        // Inserted before the last object, so it is unioned in and the last object's join stays the --csg one
+        SDFObject ellipsoid(nextSdfId++, SDFType::SPHERE);
+        ellipsoid.position = vec3(-2.46f, 0.32f, -1.37f);
+        ellipsoid.rotation = vec3(0.0f, 65.0f, 115.0f);
+        ellipsoid.parameters = vec3(0.8f, 0.13f, 0.13f);
+        ellipsoid.color = vec3(0.9f, 0.6f, 0.2f);
+        sdfObjects.insert(sdfObjects.end() - 1, ellipsoid);
+    }
+
+    // Packed in buffer order like SDFObjectBuffer (by blend group, then type), objectData in list order
+    vector<int> gpuOrder;
+    getGPUOrder(sdfObjects, gpuOrder);
+    vector<int> gpuIndices(sdfObjects.size());
+    vector<SDFObjectGPUData> gpuData, objectData;
+    for (const auto& obj : sdfObjects) objectData.push_back(obj.toGPUData());
+    for (size_t i = 0; i < gpuOrder.size(); ++i) {
+        gpuData.push_back(objectData[gpuOrder[i]]);
+        gpuIndices[gpuOrder[i]] = static_cast<int>(i);
+    }
+    if (settings.selectedIndex >= 0 && settings.selectedIndex < static_cast<int>(gpuIndices.size())) {
+        settings.selectedIndex = gpuIndices[settings.selectedIndex];
+    }
+
+    // Composition, the default scene's tree is a single join of the box onto the sphere
+    CSGTree csgTree;
+    csgTree.syncObjects(sdfObjects);
+    if (csgOperation != "union") {
+        CSGTree::Node* join = csgTree.findJoinOf(sdfObjects.back().id);
+        if (csgOperation == "subtract" && join) join->operation = CSGOperation::SUBTRACT;
+        else if (csgOperation == "intersect" && join) join->operation = CSGOperation::INTERSECT;
+        else { cerr << "Unknown CSG operation: " << csgOperation << endl; return -1; }
+        csgTree.markChanged();
+    }
+    vector<CSGInstruction> csgProgram;
+    if (optimizeCSG) CSGOptimizer::compile(csgTree, sdfObjects, objectData, blendSmoothness, csgProgram);
+    else csgTree.compile(sdfObjects, blendSmoothness, csgProgram);
+    remapCSGObjects(csgProgram, gpuIndices);
+
+    // Scene bounds for ray clipping, same as getSceneBounds in main.cpp
+    SDFBVH bvh;
+    bvh.build(gpuData);
+    if (bvh.getSceneBounds(settings.sceneBoundsMin, settings.sceneBoundsMax)) {
+        float growth = std::max(blendSmoothness * sdfkernels::BLEND_RADIUS_SCALE, csgTree.getMaxSmoothness(blendSmoothness));
+        settings.sceneBoundsMin -= vec3(growth);
+        settings.sceneBoundsMax += vec3(growth);
+    }
+
+    // --- Camera, same construction as Camera(vec3(0.0f, -5.0f, 1.0f)) in main.cpp ---
+    vec3 target = vec3(0.0f);
+    vec3 worldUp = vec3(0.0f, 0.0f, 1.0f);
+    vec3 position = vec3(0.0f, -5.0f, 1.0f);
+    float distanceToTarget = distance(position, target);
+    quat orientation = quatLookAt(normalize(target - position), worldUp);
+    settings.cameraPos = target + (orientation * vec3(0.0f, 0.0f, 1.0f)) * distanceToTarget;
+    settings.cameraBasis = mat3_cast(orientation);
+
+    // --- Render ---
+    SDFEvaluator evaluator;
+    evaluator.setObjects(gpuData);
+    evaluator.setBlendSmoothness(blendSmoothness);
+    evaluator.setClearColor(settings.clearColor);
+    evaluator.setCSGProgram(csgProgram);
+    if (isaName == "scalar") evaluator.setISA(SDFEvaluator::ISA::SCALAR);
+    else if (isaName == "avx2") evaluator.setISA(SDFEvaluator::ISA::AVX2);
+    else if (isaName == "avx512") evaluator.setISA(SDFEvaluator::ISA::AVX512);
+
+    if (checkPruning) {
+        // Same nesting as TileBinner: the scene bounds, then every cell of a grid from that tape, then every
+        // sub-cell (about tile sized) from the cell's tape. The sub-cell tapes are checked
+        if (csgProgram.empty()) { cout << "Plain union scene, there is no CSG program to prune." << endl; return 0; }
+        const int cells = 8;
+        const int subCells = 4;
+        const vec3 cellSize = (settings.sceneBoundsMax - settings.sceneBoundsMin) / static_cast<float>(cells);
+        const vec3 subCellSize = cellSize / static_cast<float>(subCells);
+        vector<CSGInstruction> sceneTape, cellTape, subCellTape;
+        evaluator.pruneCSG(csgProgram, settings.sceneBoundsMin, settings.sceneBoundsMax, sceneTape);
+        SDFEvaluator::PruneCheck worst;
+        size_t prunedInstructions = 0;
+        int boxCount = 0;
+        for (int cell = 0; cell < cells * cells * cells; ++cell) {
+            const vec3 cellMin = settings.sceneBoundsMin + vec3(cell % cells, (cell / cells) % cells, cell / (cells * cells)) * cellSize;
+            evaluator.pruneCSG(sceneTape, cellMin, cellMin + cellSize, cellTape);
+            for (int subCell = 0; subCell < subCells * subCells * subCells; ++subCell) {
+                const vec3 boxMin = cellMin + vec3(subCell % subCells, (subCell / subCells) % subCells, subCell / (subCells * subCells)) * subCellSize;
+                evaluator.pruneCSG(cellTape, boxMin, boxMin + subCellSize, subCellTape);
+                prunedInstructions += csgProgram.size() - subCellTape.size();
+                ++boxCount;
+                SDFEvaluator::PruneCheck check = evaluator.checkPrunedCSG(csgProgram, subCellTape, boxMin, boxMin + subCellSize, 4);
+                worst.maxDistError = std::max(worst.maxDistError, check.maxDistError);
+                worst.maxGradientError = std::max(worst.maxGradientError, check.maxGradientError);
+                worst.maxColorError = std::max(worst.maxColorError, check.maxColorError);
+                worst.indexMismatches += check.indexMismatches;
+                worst.samples += check.samples;
+            }
+        }
+        const float tolerance = 1e-5f;
+        bool passed = worst.maxDistError <= tolerance && worst.maxGradientError <= tolerance
+                   && worst.maxColorError <= tolerance && worst.indexMismatches == 0;
+        cout << "Pruning check over " << boxCount << " boxes, " << worst.samples << " points: "
+             << prunedInstructions << " of " << csgProgram.size() * boxCount << " instructions pruned, "
+             << "max error distance " << worst.maxDistError << ", gradient " << worst.maxGradientError
+             << ", color " << worst.maxColorError << ", " << worst.indexMismatches << " index mismatches. "
+             << (passed ? "OK" : "FAILED") << endl;
+        return passed ? 0 : -1;
+    }
+
+    CPURaymarcher raymarcher(evaluator);
+    if (pickX >= 0 && pickY >= 0) {
+        int pickedIndex = raymarcher.pickObject(settings, pickX, pickY);
+        if (pickedIndex >= 0) pickedIndex = gpuOrder[pickedIndex];
+        cout << "Pick (" << pickX << ", " << pickY << "): object index " << pickedIndex;
+        if (pickedIndex >= 0) cout << " (" << sdfObjects[pickedIndex].name << ", ID " << sdfObjects[pickedIndex].id << ")";
+        cout << endl;
+        return 0;
+    }
+
+    ThreadPool pool(threadCount);
+    CPURenderImage image;
+
+    cout << "Rendering " << settings.width << "x" << settings.height << " (debug mode " << settings.debugMode
+         << ", " << pool.getThreadCount() << " threads, " << SDFEvaluator::getISAName(evaluator.getISA()) << ")..." << endl;
+    auto start = chrono::steady_clock::now();
+    raymarcher.render(settings, pool, image);
+    double elapsedMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    cout << "Rendered in " << elapsedMs << " ms." << endl;
+
+    bool isPFM = outPath.size() >= 4 && outPath.compare(outPath.size() - 4, 4, ".pfm") == 0;
+    bool written = isPFM ? utility::writePFM(outPath, image.width, image.height, image.color)
+                         : utility::writePPM(outPath, image.width, image.height, image.color);
+    if (!written) return -1;
+    cout << "Wrote " << outPath << endl;
+    return 0;
+}
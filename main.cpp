@@ -7,6 +7,8 @@
 #include <vector>
 #include <string>
 #include <map>
+#include <algorithm>
+#include <chrono>
 #include <cstring> //
 #include "UI/AstralUI.h"
 #include "utilities/utility.h"
@@ -17,7 +19,22 @@
 #include <iomanip>
 
 #include "Basic/SDFObject.h"
+#include "Basic/SDFPrimitives.h"
 #include "Basic/TransformManager.h"
+#include "Basic/SDFEvaluator.h"
+#include "Basic/CPURaymarcher.h"
+#include "Basic/SDFObjectBuffer.h"
+#include "Basic/FrameConstants.h"
+#include "Basic/PersistentRingBuffer.h"
+#include "Basic/TileBinner.h"
+#include "Basic/PickReadback.h"
+#include "Basic/SceneCodegen.h"
+#include "Basic/CSGTree.h"
+#include "Basic/CSGOptimizer.h"
+#include "utilities/ThreadPool.h"
+#include "utilities/ShaderCache.h"
+#include "utilities/ShaderPermutations.h"
+#include "utilities/GPUProfiler.h"
 
 bool pickRequested = false;
 int pickMouseX = 0;
@@ -35,26 +52,65 @@ unsigned int SCR_WIDTH = 1920;
 unsigned int SCR_HEIGHT = 1080;
 
 // Constants
-const int MAX_SDF_OBJECTS = 10; // Match GLSL
-const int UBO_BINDING_POINT = 0;
+const int SSBO_BINDING_POINT = 0; // SDFBlock in raymarch.frag
+const int FRAME_UBO_BINDING_POINT = 1; // FrameBlock in raymarch.frag
+const int BVH_SSBO_BINDING_POINT = 2; // BVHBlock in raymarch.frag
+const int TILE_SSBO_BINDING_POINT = 3; // TileBlock in raymarch.frag
+const int CSG_SSBO_BINDING_POINT = 4; // CSGBlock in raymarch.frag
 
 // OpenGL Handles & VAO/VBO
 unsigned int quadVAO = 0;
 unsigned int quadVBO = 0;
-GLuint shaderProgram = 0;
-GLuint sdfDataUBO = 0;
+GLuint shaderProgram = 0;               // Uber shader: every mode read from the FrameBlock
+ShaderPermutationCache shaderVariants;  // Same shader with the modes fixed by #defines, see ShaderPermutations.h
+SDFObjectBuffer sdfObjectBuffer;
+PersistentRingBuffer frameConstantsRing;
+GPUProfiler gpuProfiler;
+TileBinner tileBinner;
+PersistentRingBuffer tileRing;
+size_t tileRingCapacity = 0; // uint32 entries per slot
 GLuint renderFBO = 0;
 GLuint colorTexture = 0;
 GLuint pickingTexture = 0;
 GLuint depthRenderbuffer = 0;
+PickReadback pickReadback;
+CSGTree csgTree;                        // Scene composition, edited in the Inspector
+std::vector<CSGInstruction> csgProgram; // What csgSSBO holds, empty = plain smooth union
+GLuint csgSSBO = 0;
+size_t csgSSBOCapacity = 0;             // Instructions
+uint64_t compiledCSGVersion = 0;
+float compiledCSGSmoothness = -1.0f;
+bool compiledCSGOptimized = false;
+std::string csgStatus;                  // Shown under Optimize CSG, set when the program is compiled
+SDFEvaluator pickEvaluator; // CPU copy of the scene for ray-cast picking, refreshed when objects change
+
+// Specialized scene shader (SceneCodegen): built in the background, drawn with only while it matches the objects
+SceneCodegen sceneCodegen;
+GLuint generatedProgram = 0;
+std::string generatedProgramCode;       // Defines + scene code generatedProgram was built from
+PendingProgram pendingGeneratedProgram;
+std::string pendingGeneratedCode;
+std::string failedGeneratedCode;        // Don't retry a build that failed until the code or defines change
+double sceneCodeChangedTime = 0.0;
+bool generatedSceneBusy = false;        // Build pending or about to start, keeps the loop from sleeping
+const double GENERATED_SCENE_SETTLE_TIME = 0.25; // Seconds the code must stay the same before a build starts (slider drags)
 
 // Global App State
 Camera camera(vec3(0.0f, -5.0f, 1.0f));
 vector<SDFObject> sdfObjects;
 int nextSdfId = 0;
 int selectedObjectId = -1;
+int hoveredObjectIndex = -1; // Buffer index (SDFObjectBuffer order) under the cursor (hover highlight), -1 for none
 bool useGizmo = false;
 
+// Render-on-demand: the scene is only raymarched again when sceneVersion moves past renderedSceneVersion
+uint64_t sceneVersion = 1;
+uint64_t renderedSceneVersion = 0;
+FrameConstants renderedConstants{};     // Inputs of the frame currently in colorTexture
+GLuint renderedProgram = 0;             // Program that drew it (generic or specialized)
+const int IDLE_FRAMES_BEFORE_WAIT = 3;  // Unchanged frames before sleeping in glfwWaitEventsTimeout (lets ImGui settle)
+const double IDLE_WAIT_TIMEOUT = 0.5;   // Seconds, keeps the Info panel ticking while idle
+
 
 // Helper function to check and print OpenGL errors
 GLenum glCheckError_(const char *file, int line) {
@@ -76,44 +132,6 @@ GLenum glCheckError_(const char *file, int line) {
 #define glCheckError() glCheckError_(__FILE__, __LINE__)
 
 
-// --- Shader Compile ---
-GLuint compileShader(GLenum type, const std::string& source) {
-    GLuint shader = glCreateShader(type);
-    const char* src = source.c_str();
-    glShaderSource(shader, 1, &src, NULL);
-    glCompileShader(shader);
-    GLint success; GLchar infoLog[1024];
-    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
-    glGetShaderInfoLog(shader, 1024, NULL, infoLog);
-    if (!success) {
-        cerr << "ERROR::SHADER::COMPILATION_FAILED (" << (type == GL_VERTEX_SHADER ? "VERTEX" : "FRAGMENT") << ")\n" << infoLog << endl;
-        glDeleteShader(shader); return 0;
-    } else if (strlen(infoLog) > 0) { cout << "Shader Compile Log (" << (type == GL_VERTEX_SHADER ? "VERTEX" : "FRAGMENT") << " - Success with messages):\n" << infoLog << endl;}
-    return shader;
-}
-
-// --- Link Program ---
-GLuint linkProgram(GLuint vertexShader, GLuint fragmentShader) {
-    GLuint program = glCreateProgram();
-    glAttachShader(program, vertexShader);
-    glAttachShader(program, fragmentShader);
-    glLinkProgram(program);  // Check right after a link
-
-    GLint success; GLchar infoLog[1024];
-    glGetProgramiv(program, GL_LINK_STATUS, &success);
-    glGetProgramInfoLog(program, 1024, NULL, infoLog);
-    if (!success) {
-        cerr << "ERROR::PROGRAM::LINKING_FAILED\n" << infoLog << endl;
-        glDeleteProgram(program); return 0;
-    } else if (strlen(infoLog) > 0) { cout << "Program (ID: " << program << ") Link Log (Success with messages):\n" << infoLog << endl; }
-
-    // Detach shaders immediately after a successful link
-    glDetachShader(program, vertexShader);
-    glDetachShader(program, fragmentShader);
-
-    return program;
-}
-
 void setupRenderFBO(int width, int height) {
     // Cleanup existing FBO resources
     if (renderFBO) {
@@ -185,7 +203,91 @@ void setupRenderFBO(int width, int height) {
 }
 
 
-void handlePickingRequest(int windowWidth, int windowHeight) {
+// AABB every ray is clipped to: the BVH root (rebuilt or refit whenever objects change) grown by the blend radius
+// or the largest CSG union k, since smooth blending can bulge a surface past its object's bounds. Inverted when the
+// scene is empty
+void getSceneBounds(float blendSmoothness, vec3& outMin, vec3& outMax) {
+    if (!sdfObjectBuffer.getBVH().getSceneBounds(outMin, outMax)) {
+        outMin = vec3(1.0f);
+        outMax = vec3(-1.0f);
+        return;
+    }
+    float growth = std::max(blendSmoothness * sdfkernels::BLEND_RADIUS_SCALE, csgTree.getMaxSmoothness(blendSmoothness));
+    outMin -= vec3(growth);
+    outMax += vec3(growth);
+}
+
+// --- CPU Picking ---
+// The uniforms of this frame, for the CPU raymarcher
+CPURenderSettings makeCPURenderSettings(int width, int height, const RenderParams& params, int debugMode, int selectedIndex) {
+    CPURenderSettings settings;
+    settings.width = width;
+    settings.height = height;
+    settings.cameraPos = camera.Position;
+    settings.cameraBasis = camera.GetBasisMatrix();
+    settings.fov = camera.Fov;
+    settings.clearColor = vec3(params.clearColor[0], params.clearColor[1], params.clearColor[2]);
+    settings.debugMode = debugMode;
+    settings.selectedIndex = selectedIndex;
+    settings.hoveredIndex = params.hoverHighlight ? hoveredObjectIndex : -1;
+    settings.normalMethod = static_cast<int>(params.normalMethod);
+    settings.lighting = params.lighting;
+    settings.selectionHighlight = params.selectionHighlight;
+    settings.relaxation = params.relaxation;
+    settings.stepsCompare = params.stepsCompare;
+    QualitySettings quality = getQualitySettings(params.quality);
+    settings.maxSteps = quality.maxSteps;
+    settings.coneScale = quality.coneScale;
+    getSceneBounds(params.blendSmoothness, settings.sceneBoundsMin, settings.sceneBoundsMax);
+    return settings;
+}
+
+// Same object index the shader writes to out_ObjectID under the cursor, without touching the GPU
+int cpuPick(int mouseX, int mouseY, int windowWidth, int windowHeight, const RenderParams& params) {
+    pickEvaluator.setBlendSmoothness(params.blendSmoothness);
+    pickEvaluator.setClearColor(vec3(params.clearColor[0], params.clearColor[1], params.clearColor[2]));
+    CPURaymarcher raymarcher(pickEvaluator);
+    return raymarcher.pickObject(makeCPURenderSettings(windowWidth, windowHeight, params, 0, -1), mouseX, mouseY);
+}
+
+// Selects (or deselects) from a finished click read, pickedIndex is a buffer index like every pick result
+void applyPickResult(int pickedIndex) {
+    pickedIndex = sdfObjectBuffer.getObjectIndex(pickedIndex);
+    if (pickedIndex >= 0 && pickedIndex < static_cast<int>(sdfObjects.size())) {
+        if (sdfObjects[pickedIndex].id != selectedObjectId) {
+            selectedObjectId = sdfObjects[pickedIndex].id;
+            useGizmo = true; // Or set based on the transform Manager state
+            std::cout << "Picked Object Index: " << pickedIndex << " -> ID: " << selectedObjectId << std::endl;
+        }
+    } else {
+        if (selectedObjectId != -1) {
+            selectedObjectId = -1;
+            useGizmo = false;
+            std::cout << "Picked Background (Index: " << pickedIndex << ")" << std::endl;
+        }
+    }
+}
+
+// Queues an async read of the picking texture under the cursor, the result arrives in processPickResults()
+bool queuePickRead(int mouseX, int mouseY, int windowWidth, int windowHeight, PickReadback::Purpose purpose) {
+    int readY = windowHeight - 1 - mouseY;
+    if (mouseX < 0 || mouseX >= windowWidth || readY < 0 || readY >= windowHeight) {
+        if (purpose == PickReadback::Purpose::CLICK) std::cerr << "Warning::PICKING:: Coordinates out of bounds." << std::endl;
+        return true; // Nothing to read, don't retry
+    }
+
+    // Bind Picking FBO
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, renderFBO);
+    glReadBuffer(GL_COLOR_ATTACHMENT1);
+    bool queued = pickReadback.request(mouseX, readY, purpose);
+    glCheckError(); // Check RIGHT AFTER glReadPixels
+
+    // Unbind the read framebuffer
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    return queued;
+}
+
+void handlePickingRequest(int windowWidth, int windowHeight, const RenderParams& params) {
     if (!pickRequested || windowWidth <= 0 || windowHeight <= 0) {
         if (!pickRequested) return;
         pickRequested = false;
@@ -193,45 +295,66 @@ void handlePickingRequest(int windowWidth, int windowHeight) {
     }
     pickRequested = false;
 
+    if (params.pickingMode == PickingMode::CPU_RAYCAST) {
+        applyPickResult(cpuPick(pickMouseX, pickMouseY, windowWidth, windowHeight, params));
+        return;
+    }
+
     if (!renderFBO || !pickingTexture) {
         std::cerr << "ERROR::PICKING:: Render FBO or Picking Texture not initialized!" << std::endl;
         selectedObjectId = -1;
         useGizmo = false;
         return;
     }
-    // Bind Picking FBO & Set Viewport
-    glBindFramebuffer(GL_READ_FRAMEBUFFER, renderFBO);
 
-    glReadBuffer(GL_COLOR_ATTACHMENT1);
-
-    int pickedIndex = -1;
-    int readY = windowHeight - 1 - pickMouseY;
+    if (!queuePickRead(pickMouseX, pickMouseY, windowWidth, windowHeight, PickReadback::Purpose::CLICK)) {
+        pickRequested = true; // Every readback slot is busy, try again next frame
+    }
+}
 
-    if (pickMouseX >= 0 && pickMouseX < windowWidth && readY >= 0 && readY < windowHeight) {
-        glReadPixels( pickMouseX, readY, 1, 1, GL_RED_INTEGER, GL_INT, &pickedIndex);
-        glCheckError(); // Check RIGHT AFTER glReadPixels
-    } else {
-        std::cerr << "Warning::PICKING:: Coordinates out of bounds." << std::endl;
+// Hands out the reads that finished since last frame, never waits on the GPU
+void processPickResults() {
+    PickReadback::Result result;
+    while (pickReadback.poll(result)) {
+        if (result.purpose == PickReadback::Purpose::CLICK) {
+            applyPickResult(result.value);
+        } else {
+            hoveredObjectIndex = result.value;
+        }
     }
+}
 
-    // Unbind the read framebuffer
+// --- Frame Capture ---
+// Writes the current GPU frame and a CPU render of the same view, for comparing the two renderers
+void saveFrameComparison(int width, int height, const RenderParams& params, int debugMode, int selectedIndex) {
+    if (!renderFBO || width <= 0 || height <= 0) return;
+
+    std::vector<glm::vec4> gpuPixels(static_cast<size_t>(width) * height);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, renderFBO);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_FLOAT, gpuPixels.data());
     glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    glCheckError();
 
-    // --- Process the result ---
-    // ... (Processing logic remains the same) ...
-    if (pickedIndex >= 0 && pickedIndex < sdfObjects.size()) {
-        if (sdfObjects[pickedIndex].id != selectedObjectId) {
-            selectedObjectId = sdfObjects[pickedIndex].id;
-            useGizmo = true; // Or set based on the transform Manager state
-            std::cout << "Picked Object Index: " << pickedIndex << " -> ID: " << selectedObjectId << std::endl;
-        }
-    } else {
-        if (selectedObjectId != -1) {
-            selectedObjectId = -1;
-            useGizmo = false;
-            std::cout << "Picked Background (Index: " << pickedIndex << ")" << std::endl;
-        }
-    }
+    std::vector<glm::vec3> gpuColor(gpuPixels.size());
+    for (size_t i = 0; i < gpuPixels.size(); ++i) gpuColor[i] = vec3(gpuPixels[i]);
+    utility::writePFM("astral_gpu.pfm", width, height, gpuColor);
+
+    SDFEvaluator evaluator;
+    evaluator.setObjects(sdfObjectBuffer.getData()); // Same order as csgProgram and selectedIndex
+    evaluator.setCSGProgram(csgProgram);
+    evaluator.setBlendSmoothness(params.blendSmoothness);
+    evaluator.setClearColor(vec3(params.clearColor[0], params.clearColor[1], params.clearColor[2]));
+
+    CPURenderSettings settings = makeCPURenderSettings(width, height, params, debugMode, selectedIndex);
+
+    static ThreadPool pool;
+    CPURaymarcher raymarcher(evaluator);
+    CPURenderImage image;
+    raymarcher.render(settings, pool, image);
+    utility::writePFM("astral_cpu.pfm", image.width, image.height, image.color);
+
+    std::cout << "Saved astral_gpu.pfm and astral_cpu.pfm (" << width << "x" << height << ")" << std::endl;
 }
 
 // --- Framebuffer Resize ---
@@ -239,52 +362,257 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
     if (width > 0 && height > 0) {
         glViewport(0, 0, width, height);
         setupRenderFBO(width, height);
+        ++sceneVersion; // New textures are empty
     }
 }
 
-// --- UBO ---
-void updateSDFUBOData() {
-    int numObjectsToSend = std::min((int)sdfObjects.size(), MAX_SDF_OBJECTS);
-    if (numObjectsToSend <= 0) {
-        return;
+// --- SSBO ---
+// sdfObjects stays in the user's order, the buffer sorts its copy by blend group and type
+void updateSDFObjectBuffer() {
+    sdfObjectBuffer.upload(sdfObjects);
+}
+
+void setupSSBO() {
+    cout << "Setting up SDF object SSBO..." << endl;
+    sdfObjectBuffer.init(SSBO_BINDING_POINT, BVH_SSBO_BINDING_POINT);
+
+    // The block uses layout(binding = 0), just make sure the shader actually declares it
+    cout << "Checking SSBO for Main Shader (Program ID: " << shaderProgram << ")" << endl;
+    if (shaderProgram != 0) {
+        GLuint blockIndexMain = glGetProgramResourceIndex(shaderProgram, GL_SHADER_STORAGE_BLOCK, "SDFBlock");
+        cout << "  Main Shader - glGetProgramResourceIndex for 'SDFBlock' returned: " << blockIndexMain << endl;
+        if (blockIndexMain != GL_INVALID_INDEX) {
+            glShaderStorageBlockBinding(shaderProgram, blockIndexMain, SSBO_BINDING_POINT);
+            cout << "  Main Shader - Bound 'SDFBlock' to binding point " << SSBO_BINDING_POINT << "." << endl;
+        } else { cerr << "!!!!!! Warning: Storage block 'SDFBlock' NOT FOUND in main shader program. !!!!!!" << endl; }
+
+        GLuint bvhBlockIndex = glGetProgramResourceIndex(shaderProgram, GL_SHADER_STORAGE_BLOCK, "BVHBlock");
+        if (bvhBlockIndex != GL_INVALID_INDEX) {
+            glShaderStorageBlockBinding(shaderProgram, bvhBlockIndex, BVH_SSBO_BINDING_POINT);
+            cout << "  Main Shader - Bound 'BVHBlock' to binding point " << BVH_SSBO_BINDING_POINT << "." << endl;
+        } else { cerr << "!!!!!! Warning: Storage block 'BVHBlock' NOT FOUND in main shader program. !!!!!!" << endl; }
+
+        GLuint tileBlockIndex = glGetProgramResourceIndex(shaderProgram, GL_SHADER_STORAGE_BLOCK, "TileBlock");
+        if (tileBlockIndex != GL_INVALID_INDEX) {
+            glShaderStorageBlockBinding(shaderProgram, tileBlockIndex, TILE_SSBO_BINDING_POINT);
+            cout << "  Main Shader - Bound 'TileBlock' to binding point " << TILE_SSBO_BINDING_POINT << "." << endl;
+        } else { cerr << "!!!!!! Warning: Storage block 'TileBlock' NOT FOUND in main shader program. !!!!!!" << endl; }
+    } else { cerr << "Error: Main shader program handle is invalid before SSBO setup." << endl; }
+}
+
+// --- Scene CSG Program ---
+void setupCSGBuffer() {
+    glGenBuffers(1, &csgSSBO);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, csgSSBO);
+    csgSSBOCapacity = 64;
+    glBufferData(GL_SHADER_STORAGE_BUFFER, static_cast<GLsizeiptr>(csgSSBOCapacity * sizeof(CSGInstruction)), nullptr, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CSG_SSBO_BINDING_POINT, csgSSBO);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    glCheckError();
+}
+
+// Follows the object list, compiles the tree after an edit and re-uploads the program if it changed
+// (8 bytes per instruction, no shader rebuild). The optimizer reads the object bounds, so with it on the tree is
+// also compiled again when objects change. The program pushes buffer indices, so it is also compiled again when
+// the buffer order changes. Returns true when the program changed
+bool updateCSGProgram(const RenderParams& params, bool objectsChanged, std::string& outStatus) {
+    csgTree.syncObjects(sdfObjects);
+    if (csgTree.getVersion() == compiledCSGVersion && params.blendSmoothness == compiledCSGSmoothness
+        && params.optimizeCSG == compiledCSGOptimized && !(params.optimizeCSG && objectsChanged)
+        && !sdfObjectBuffer.wasStructureChanged()) return false;
+    compiledCSGVersion = csgTree.getVersion();
+    compiledCSGSmoothness = params.blendSmoothness;
+    compiledCSGOptimized = params.optimizeCSG;
+
+    // On failure (logged) the scene draws as a plain union. The tree compiles to list indices, the shader
+    // reads buffer indices
+    std::vector<CSGInstruction> program;
+    if (params.optimizeCSG) {
+        // The optimizer wants the packed objects in list order (it falls back to the plain tree if the sizes differ)
+        const std::vector<SDFObjectGPUData>& bufferData = sdfObjectBuffer.getData();
+        std::vector<SDFObjectGPUData> objectData;
+        if (bufferData.size() == sdfObjects.size()) {
+            for (size_t i = 0; i < sdfObjects.size(); ++i) objectData.push_back(bufferData[sdfObjectBuffer.getGPUIndex(static_cast<int>(i))]);
+        }
+        CSGOptimizer::Stats stats;
+        CSGOptimizer::compile(csgTree, sdfObjects, objectData, params.blendSmoothness, program, &stats);
+        outStatus = to_string(program.size()) + " CSG instructions, " + to_string(stats.demotedBlends) + " blends made sharp, "
+                  + to_string(stats.prunedJoins) + " joins pruned";
+    } else {
+        csgTree.compile(sdfObjects, params.blendSmoothness, program);
+        outStatus = to_string(program.size()) + " CSG instructions";
+    }
+    remapCSGObjects(program, sdfObjectBuffer.getGPUIndices());
+    if (program == csgProgram) return false;
+    csgProgram.swap(program);
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, csgSSBO);
+    if (csgProgram.size() > csgSSBOCapacity) {
+        while (csgSSBOCapacity < csgProgram.size()) csgSSBOCapacity *= 2;
+        glBufferData(GL_SHADER_STORAGE_BUFFER, static_cast<GLsizeiptr>(csgSSBOCapacity * sizeof(CSGInstruction)), nullptr, GL_DYNAMIC_DRAW);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CSG_SSBO_BINDING_POINT, csgSSBO);
     }
+    if (!csgProgram.empty()) {
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, static_cast<GLsizeiptr>(csgProgram.size() * sizeof(CSGInstruction)), csgProgram.data());
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    glCheckError();
 
-    std::vector<SDFObjectGPUData> gpuData(numObjectsToSend);
-    for(int i = 0; i < numObjectsToSend; ++i) {
-        const auto& obj = sdfObjects[i];
+    pickEvaluator.setCSGProgram(csgProgram);
+    return true;
+}
 
-        gpuData[i].inverseModelMatrix = obj.getInverseModelMatrix();
-        gpuData[i].color = glm::vec4(obj.color, 1.0f);
+// --- Frame Constants UBO ---
+void setupFrameConstants() {
+    cout << "Setting up frame constants ring..." << endl;
+    frameConstantsRing.create(GL_UNIFORM_BUFFER, sizeof(FrameConstants));
 
-        gpuData[i].paramsXYZ_type = glm::vec4(obj.parameters.x, obj.parameters.y, obj.parameters.z, static_cast<float>(obj.type));
+    if (shaderProgram != 0) {
+        GLuint blockIndex = glGetUniformBlockIndex(shaderProgram, "FrameBlock");
+        if (blockIndex != GL_INVALID_INDEX) {
+            glUniformBlockBinding(shaderProgram, blockIndex, FRAME_UBO_BINDING_POINT);
+            cout << "  Main Shader - Bound 'FrameBlock' to binding point " << FRAME_UBO_BINDING_POINT << "." << endl;
+        } else { cerr << "!!!!!! Warning: Uniform block 'FrameBlock' NOT FOUND in main shader program. !!!!!!" << endl; }
     }
+}
+
+// --- Screen Tile Culling ---
+// Bins the objects (or prunes the CSG program) into screen tiles and writes the lists into this frame's ring slot
+void updateTileLists(int width, int height, const RenderParams& params) {
+    TileCamera tileCamera;
+    tileCamera.position = camera.Position;
+    tileCamera.basis = camera.GetBasisMatrix();
+    tileCamera.fov = camera.Fov;
+    tileCamera.width = width;
+    tileCamera.height = height;
+    if (csgProgram.empty()) {
+        tileBinner.bin(sdfObjectBuffer.getData(), tileCamera, params.blendSmoothness);
+    } else {
+        // pickEvaluator already holds this frame's objects and program
+        vec3 boundsMin, boundsMax;
+        getSceneBounds(params.blendSmoothness, boundsMin, boundsMax);
+        tileBinner.binCSG(pickEvaluator, tileCamera, boundsMin, boundsMax);
+    }
+
+    const std::vector<uint32_t>& data = tileBinner.getData();
+    if (data.size() > tileRingCapacity) {
+        size_t newCapacity = std::max<size_t>(tileRingCapacity, 1024);
+        while (newCapacity < data.size()) newCapacity *= 2;
+        if (!tileRing.create(GL_SHADER_STORAGE_BUFFER, static_cast<GLsizeiptr>(newCapacity * sizeof(uint32_t)))) {
+            tileRingCapacity = 0;
+            return;
+        }
+        tileRingCapacity = newCapacity;
+    }
+
+    // The lists change with the camera, so every frame gets a full copy
+    memcpy(tileRing.acquireSlot(), data.data(), data.size() * sizeof(uint32_t));
+    tileRing.bindSlot(TILE_SSBO_BINDING_POINT);
+}
 
-    glBindBuffer(GL_UNIFORM_BUFFER, sdfDataUBO);
-    // Update the buffer - ensure size matches gpuData size correctly
-    glBufferSubData(GL_UNIFORM_BUFFER, 0, gpuData.size() * sizeof(SDFObjectGPUData), gpuData.data());
-    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+// Everything the shader used to get through glUniform*
+FrameConstants buildFrameConstants(int width, int height, const RenderParams& params, int debugMode, int selectedIndex) {
+    FrameConstants constants{};
+    mat3 basis = camera.GetBasisMatrix();
+    for (int c = 0; c < 3; ++c) constants.cameraBasis[c] = vec4(basis[c], 0.0f);
+    constants.cameraPos = camera.Position;
+    constants.fov = camera.Fov;
+    constants.clearColor = vec3(params.clearColor[0], params.clearColor[1], params.clearColor[2]);
+    constants.blendSmoothness = params.blendSmoothness;
+    constants.resolution = vec2(static_cast<float>(width), static_cast<float>(height));
+    constants.sdfCount = sdfObjectBuffer.getCount();
+    constants.csgLength = static_cast<int>(csgProgram.size());
+    constants.selectedObjectID = selectedIndex;
+    constants.debugMode = debugMode;
+    constants.bvhNodeCount = sdfObjectBuffer.getBVH().getNodeCount();
+    constants.hoveredObjectID = params.hoverHighlight ? hoveredObjectIndex : -1;
+    constants.cullingMode = static_cast<int>(params.cullingMode);
+    constants.normalMethod = static_cast<int>(params.normalMethod);
+    constants.lighting = params.lighting ? 1 : 0;
+    constants.selectionHighlight = params.selectionHighlight ? 1 : 0;
+    constants.relaxation = params.relaxation;
+    constants.stepsCompare = params.stepsCompare ? 1 : 0;
+    QualitySettings quality = getQualitySettings(params.quality);
+    constants.maxSteps = quality.maxSteps;
+    constants.coneScale = quality.coneScale;
+    getSceneBounds(params.blendSmoothness, constants.sceneBoundsMin, constants.sceneBoundsMax);
+    constants.tileSize = tileBinner.getTileSize();
+    constants.tilesX = tileBinner.getTilesX();
+    if (params.cullingMode == CullingMode::TILES && !tileRing.isCreated()) {
+        constants.cullingMode = static_cast<int>(CullingMode::NONE);
+    }
+    return constants;
 }
 
-void setupUBO() {
-    cout << "Setting up UBO..." << endl;
-    glGenBuffers(1, &sdfDataUBO);
-    glBindBuffer(GL_UNIFORM_BUFFER, sdfDataUBO);
-    glBufferData(GL_UNIFORM_BUFFER, MAX_SDF_OBJECTS * sizeof(SDFObjectGPUData), nullptr, GL_DYNAMIC_DRAW);
-    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+// --- Specialized Scene Shader ---
+// Keeps the generated program in step with the objects and returns the program to draw with this frame:
+// the generated one when it matches the current code and permutation defines, fallbackProgram otherwise
+GLuint updateGeneratedScene(ShaderCache& cache, const string& vertexSource, const string& fragmentSource,
+                            const RenderParams& params, const string& permutationDefines, GLuint fallbackProgram,
+                            bool objectsChanged, double currentTime, string& outStatus) {
+    if (!params.generatedScene) {
+        generatedSceneBusy = false;
+        if (pendingGeneratedProgram.isActive()) cache.cancelProgram(pendingGeneratedProgram);
+        sceneCodegen.reset(); // Fold everything again when it is turned back on
+        outStatus = "Off, objects interpreted from the SSBO";
+        return fallbackProgram;
+    }
 
-    glBindBufferBase(GL_UNIFORM_BUFFER, UBO_BINDING_POINT, sdfDataUBO);
+    if (objectsChanged || sceneCodegen.getCode().empty()) {
+        if (sceneCodegen.update(sdfObjectBuffer.getData(), sdfObjectBuffer.wasStructureChanged())) sceneCodeChangedTime = currentTime;
+    }
+    // The defines go in after #version like every variant's, only the scene code is spliced at the marker.
+    // A program matches when both are the same, so the bookkeeping below compares the two together
+    const string defines = string(SceneCodegen::DEFINES) + permutationDefines;
+    const string& sceneCode = sceneCodegen.getCode();
+    const string code = defines + sceneCode;
+
+    if (pendingGeneratedProgram.isActive()) {
+        if (pendingGeneratedCode != code) {
+            cache.cancelProgram(pendingGeneratedProgram); // Outdated before it finished
+        } else if (cache.isProgramReady(pendingGeneratedProgram)) {
+            double finishStart = glfwGetTime();
+            GLuint program = cache.finishProgram(pendingGeneratedProgram);
+            if (program) {
+                if (generatedProgram) glDeleteProgram(generatedProgram);
+                generatedProgram = program; // Blocks use explicit layout(binding), nothing to re-bind
+                generatedProgramCode = pendingGeneratedCode;
+                cout << "Specialized scene shader ready (ID: " << program << ", " << sceneCodegen.getObjectCount() << " objects), finish took "
+                     << (glfwGetTime() - finishStart) * 1000.0 << " ms." << endl;
+            } else {
+                cerr << "ERROR::SCENE_CODEGEN::BUILD_FAILED, staying on the generic shader" << endl;
+                failedGeneratedCode = pendingGeneratedCode;
+            }
+        }
+    }
 
-    // Link Shader Blocks (Assume shaderProgram and pickingShaderProgram are valid)
-    // Main Shader
-    cout << "Checking & Binding UBO for Main Shader (Program ID: " << shaderProgram << ")" << endl;
-    if (shaderProgram != 0) {
-        GLuint blockIndexMain = glGetUniformBlockIndex(shaderProgram, "SDFBlock");
-        cout << "  Main Shader - glGetUniformBlockIndex for 'SDFBlock' returned: " << blockIndexMain << endl;
-        if (blockIndexMain != GL_INVALID_INDEX) {
-            glUniformBlockBinding(shaderProgram, blockIndexMain, UBO_BINDING_POINT);
-            cout << "  Main Shader - Bound 'SDFBlock' to binding point " << UBO_BINDING_POINT << "." << endl;
-        } else { cerr << "!!!!!! Warning: Uniform block 'SDFBlock' NOT FOUND in main shader program. !!!!!!" << endl; }
-    } else { cerr << "Error: Main shader program handle is invalid before UBO setup." << endl; }
+    bool upToDate = (generatedProgram != 0 && generatedProgramCode == code);
+    if (!upToDate && !pendingGeneratedProgram.isActive() && code != failedGeneratedCode
+        && currentTime - sceneCodeChangedTime >= GENERATED_SCENE_SETTLE_TIME) {
+        string source = SceneCodegen::insertInto(fragmentSource, sceneCode);
+        if (source.empty()) {
+            cerr << "ERROR::SCENE_CODEGEN::MARKER_NOT_FOUND in " << FRAGMENT_SHADER_PATH << endl;
+            failedGeneratedCode = code;
+        } else {
+            pendingGeneratedProgram = cache.beginProgram(vertexSource, source, defines);
+            pendingGeneratedCode = code;
+        }
+    }
+    generatedSceneBusy = pendingGeneratedProgram.isActive() || (!upToDate && code != failedGeneratedCode);
+
+    if (upToDate) {
+        outStatus = "Specialized: " + to_string(sceneCodegen.getObjectCount()) + " objects, "
+                  + to_string(sceneCodegen.getDynamicCount()) + " with SSBO transforms";
+        return generatedProgram;
+    }
+    outStatus = (code == failedGeneratedCode) ? "Build failed, interpreting the SSBO" : "Building specialized shader (interpreting meanwhile)";
+    return fallbackProgram;
+}
+
+// Writes the constants into this frame's ring slot
+void uploadFrameConstants(const FrameConstants& constants) {
+    memcpy(frameConstantsRing.acquireSlot(), &constants, sizeof(constants));
+    frameConstantsRing.bindSlot(FRAME_UBO_BINDING_POINT);
 }
 
 // --- Main ---
@@ -305,10 +633,11 @@ int main() {
         cout << "OpenGL Version Reported by Driver: " << glGetString(GL_VERSION) << endl;
         // --- Pointer Checks ---
         bool pointers_ok = true;
-        if (glUniformBlockBinding == NULL) { cerr << "CRITICAL ERROR: glUniformBlockBinding NULL!" << endl; pointers_ok = false; }
-        if (glGetUniformBlockIndex == NULL) { cerr << "CRITICAL ERROR: glGetUniformBlockIndex NULL!" << endl; pointers_ok = false; }
+        if (glGetProgramResourceIndex == NULL) { cerr << "CRITICAL ERROR: glGetProgramResourceIndex NULL!" << endl; pointers_ok = false; }
+        if (glShaderStorageBlockBinding == NULL) { cerr << "CRITICAL ERROR: glShaderStorageBlockBinding NULL!" << endl; pointers_ok = false; }
+        if (glBufferStorage == NULL) { cerr << "CRITICAL ERROR: glBufferStorage NULL!" << endl; pointers_ok = false; }
+        if (glFenceSync == NULL || glClientWaitSync == NULL) { cerr << "CRITICAL ERROR: glFenceSync/glClientWaitSync NULL!" << endl; pointers_ok = false; }
         if (glBlendFunci == NULL) { cerr << "WARNING: glBlendFunci NULL!" << endl; /* pointers_ok = false; */ } // Less critical
-        if (glShaderStorageBlockBinding == NULL) { cerr << "WARNING: glShaderStorageBlockBinding NULL!" << endl; /* pointers_ok = false; */ } // Less critical
         if (!pointers_ok) { cerr << "Critical GLAD pointers missing!" << endl; glfwTerminate(); return -1; }
         else { cout << "Required GLAD function pointers seem to be loaded." << endl; }
     }
@@ -321,6 +650,10 @@ int main() {
 
     // --- Init UI & Callbacks ---
     AstralUI ui(window);
+    gpuProfiler.init();
+    pickReadback.init();
+    ui.setProfiler(&gpuProfiler);
+    ui.setCSGTree(&csgTree);
     glfwSetWindowUserPointer(window, &camera);
     glfwSetMouseButtonCallback(window, Camera::MouseButtonCallback);
     glfwSetCursorPosCallback(window, Camera::CursorPosCallback);
@@ -332,50 +665,28 @@ int main() {
     string vertexShaderCode = utility::loadShaderSource(VERTEX_SHADER_PATH);
     string fragmentShaderCode = utility::loadShaderSource(FRAGMENT_SHADER_PATH);
     if (vertexShaderCode.empty() || fragmentShaderCode.empty()) { cerr << "Failed to load shaders!" << endl; return -1; }
+    // Primitive functions from the registry, every program below (variants, specialized scenes) starts from this
+    fragmentShaderCode = SDFPrimitives::insertInto(fragmentShaderCode);
+    if (fragmentShaderCode.empty()) { cerr << "ERROR::SHADER::PRIMITIVES_MARKER_NOT_FOUND in " << FRAGMENT_SHADER_PATH << endl; return -1; }
     cout << "Shaders loaded." << endl;
 
 
-    // --- Compile ALL Shaders ---
-    cout << "Compiling shaders..." << endl;
-    GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexShaderCode);
-    GLuint mainFragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentShaderCode);
-    if (!vertexShader || !mainFragmentShader ) { cerr << "Shader compilation failed." << endl; return -1; }
-    cout << "Shaders compiled." << endl;
-
-
-    // --- Link MAIN Program ---
-    cout << "Linking main program..." << endl;
-    shaderProgram = linkProgram(vertexShader, mainFragmentShader);
-    if (shaderProgram == 0) { cerr << "Main program linking failed." << endl; /* Delete shaders? */ return -1; }
-    cout << "Main program linked (ID: " << shaderProgram << ")." << endl;
-
-    // --- Delete individual shaders (no longer needed) ---
-    cout << "Deleting individual shaders..." << endl;
-    glDeleteShader(vertexShader);
-    glDeleteShader(mainFragmentShader);
-
-    // --- Get NON-UBO Uniform Locations ---
-    cout << "Getting non-UBO uniform locations..." << endl;
-    GLint u_resolutionLoc, u_cameraPosLoc, u_cameraBasisLoc, u_fovLoc, u_clearColorLoc,
-          u_debugModeLoc, u_blendSmoothnessLoc, u_sdfCountLoc, u_selectedObjectIDLoc;
-    // Main Program
-    glUseProgram(shaderProgram);
-    u_resolutionLoc = glGetUniformLocation(shaderProgram, "u_resolution");
-    u_cameraPosLoc = glGetUniformLocation(shaderProgram, "u_cameraPos");
-    u_cameraBasisLoc = glGetUniformLocation(shaderProgram, "u_cameraBasis");
-    u_fovLoc = glGetUniformLocation(shaderProgram, "u_fov");
-    u_clearColorLoc = glGetUniformLocation(shaderProgram, "u_clearColor");
-    u_debugModeLoc = glGetUniformLocation(shaderProgram, "u_debugMode");
-    u_blendSmoothnessLoc = glGetUniformLocation(shaderProgram, "u_blendSmoothness");
-    u_sdfCountLoc = glGetUniformLocation(shaderProgram, "u_sdfCount");
-    u_selectedObjectIDLoc = glGetUniformLocation(shaderProgram, "u_selectedObjectID");
-    glUseProgram(0);
-    cout << "Finished getting non-UBO uniform locations for main shader." << endl;
-
-
-    // --- Set up UBO (AFTER linking and getting other uniforms) ---
-    setupUBO(); // Contains the block index query and binding
-     // Check state AFTER UBO setup
+    // --- Compile + Link MAIN Program (or restore it from the binary cache) ---
+    cout << "Building main program..." << endl;
+    double programStart = glfwGetTime();
+    ShaderCache shaderCache;
+    shaderProgram = shaderCache.loadProgram(vertexShaderCode, fragmentShaderCode);
+    if (shaderProgram == 0) { cerr << "Main program build failed." << endl; return -1; }
+    cout << "Main program " << (shaderCache.wasLastLoadCached() ? "restored from cache" : "compiled and linked")
+         << " (ID: " << shaderProgram << ") in " << (glfwGetTime() - programStart) * 1000.0 << " ms." << endl;
+
+    shaderVariants.init(&shaderCache, vertexShaderCode, fragmentShaderCode);
+
+    // --- Set up SSBO (AFTER linking and getting other uniforms) ---
+    setupSSBO(); // Contains the block index query and binding
+    setupFrameConstants();
+    setupCSGBuffer();
+     // Check state AFTER SSBO setup
 
     // --- Setup Quad & FBO ---
     cout << "Setting up Quad and FBO..." << endl;
@@ -393,19 +704,7 @@ int main() {
 
     // --- Initialize SDF Objects ---
     cout << "Initializing SDF Objects..." << endl;
-    SDFObject sphere1(nextSdfId++);
-    sphere1.type = SDFType::SPHERE;
-    sphere1.position = vec3(-1.5f, 0.0f, 0.0f);
-    sphere1.parameters = vec3(0.8f); // Set all radii to 0.8 for a uniform sphere
-    sphere1.color = vec3(1.0f, 1.0f, 1.0f);
-    sdfObjects.push_back(sphere1);
-
-    SDFObject box1(nextSdfId++);
-    box1.type = SDFType::BOX;
-    box1.position = vec3(1.5f, 0.0f, 0.0f);
-    box1.parameters = vec3(0.6f, 0.7f, 0.8f); // Set half-sizes directly
-    box1.color = vec3(1.0f, 1.0f, 1.0f);
-    sdfObjects.push_back(box1);
+    createDefaultScene(sdfObjects, nextSdfId);
 
 
     // Initialize Transform Manager
@@ -421,6 +720,8 @@ int main() {
     static size_t currentRSS = 0;
     static int frameCounter = 0;
     const int ramUpdateInterval = 60; // Update RAM roughly every second
+    int idleFrames = 0;               // Frames in a row without a scene change
+    auto nextFrameDeadline = std::chrono::steady_clock::now(); // FPS cap pacing
     // gpuFrameTimeNano is already declared globally
 
 
@@ -428,15 +729,22 @@ int main() {
     while (!glfwWindowShouldClose(window))
     {
 
-        // --- Timing & Basic Events ---
+        // --- Basic Events & Timing ---
+        // Nothing changed for a few frames: sleep until input arrives instead of spinning
+        bool waitedForEvents = ui.getParams().renderOnDemand && idleFrames >= IDLE_FRAMES_BEFORE_WAIT;
+        if (waitedForEvents) {
+            glfwWaitEventsTimeout(IDLE_WAIT_TIMEOUT);
+            idleFrames = 0;
+        } else {
+            glfwPollEvents();
+        }
         double currentTime = glfwGetTime();
-        deltaTime = currentTime - lastTime;
+        deltaTime = waitedForEvents ? 0.0 : currentTime - lastTime; // Don't turn the idle time into a camera jump
         lastTime = currentTime;
-        glfwPollEvents();
         if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) glfwSetWindowShouldClose(window, true);
 
-        // --- Update UBO ---
-        updateSDFUBOData();
+        gpuProfiler.beginFrame();
+        processPickResults();
 
         // --- Begin ImGui Frame ---
         ui.newFrame();
@@ -468,48 +776,120 @@ int main() {
         }
 
 
-        // --- Setup for Main Render Pass Viewport & Aspect Ratio ---
-        glBindFramebuffer(GL_FRAMEBUFFER, renderFBO);
-        glViewport(0, 0, display_w, display_h);
+        // --- Has anything the raymarcher reads changed? ---
+        // Objects are uploaded after TransformManager, so the object data and the tile lists describe the same frame
+        updateSDFObjectBuffer();
+        bool objectsChanged = !sdfObjectBuffer.getChangedIndices().empty() || sdfObjectBuffer.wasStructureChanged();
+        if (objectsChanged) pickEvaluator.setObjects(sdfObjectBuffer.getData());
+        bool csgChanged = updateCSGProgram(params, objectsChanged, csgStatus);
+        ui.setCSGStatus(csgStatus);
+        int selectedObjectIndex = sdfObjectBuffer.getGPUIndex(findObjectIndex(sdfObjects, selectedObjectId)); // In buffer order
+        FrameConstants frameConstants = buildFrameConstants(display_w, display_h, params, ui.getDebugMode(), selectedObjectIndex); // Send selected INDEX
+
+        // Shader for this frame: generated scene > permutation variant > uber shader, whichever is built
+        if (ui.consumePrewarmRequest()) shaderVariants.prewarmAll();
+        shaderVariants.poll();
+        GLuint variantProgram = shaderProgram;
+        string permutationDefines;
+        if (params.shaderVariants) {
+            ShaderPermutation permutation;
+            permutation.debugMode = ui.getDebugMode();
+            permutation.lighting = params.lighting;
+            permutation.selectionHighlight = params.selectionHighlight;
+            permutation.normalMethod = static_cast<int>(params.normalMethod);
+            if (GLuint variant = shaderVariants.get(permutation)) variantProgram = variant;
+            permutationDefines = permutation.getDefines();
+        }
+        ui.setVariantStatus(to_string(shaderVariants.getReadyCount()) + "/" + to_string(ShaderPermutation::COUNT) + " variants built, "
+                            + to_string(shaderVariants.getPendingCount()) + " building"
+                            + (params.shaderVariants && variantProgram == shaderProgram ? " (uber shader meanwhile)" : ""));
+        string sceneShaderStatus;
+        GLuint drawProgram = updateGeneratedScene(shaderCache, vertexShaderCode, fragmentShaderCode, params, permutationDefines,
+                                                  variantProgram, objectsChanged, currentTime, sceneShaderStatus);
+        ui.setSceneShaderStatus(sceneShaderStatus);
+        if (objectsChanged || csgChanged || !params.renderOnDemand || drawProgram != renderedProgram
+            || memcmp(&frameConstants, &renderedConstants, sizeof(FrameConstants)) != 0) {
+            ++sceneVersion;
+        }
 
-        // Set Draw Buffers specifically for this render pass
-        GLenum drawBuffers[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
-        glDrawBuffers(2, drawBuffers);
-        glCheckError();
+        if (sceneVersion != renderedSceneVersion) {
+            // --- Setup for Main Render Pass Viewport & Aspect Ratio ---
+            glBindFramebuffer(GL_FRAMEBUFFER, renderFBO);
+            glViewport(0, 0, display_w, display_h);
+
+            // Set Draw Buffers specifically for this render pass
+            GLenum drawBuffers[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+            glDrawBuffers(2, drawBuffers);
+            glCheckError();
+
+            // Specify clear values for BOTH atttachments
+            glClearColor(params.clearColor[0], params.clearColor[1], params.clearColor[2],  1.0f);
+            GLint clearInt = -1;
+            glClearBufferiv(GL_COLOR, 1, &clearInt);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+
+            // --- Render Main SDF Scene ---
+            glUseProgram(drawProgram);
+            if (params.cullingMode == CullingMode::TILES) {
+                updateTileLists(display_w, display_h, params);
+            }
+            uploadFrameConstants(frameConstants);
+
+            // Draw the fullscreen quad
+            gpuProfiler.beginPass(GPUProfiler::RAYMARCH);
+            glDisable(GL_DEPTH_TEST);
+            glBindVertexArray(quadVAO);
+            glDrawArrays(GL_TRIANGLES, 0, 6);
+            glBindVertexArray(0);
+            gpuProfiler.endPass(GPUProfiler::RAYMARCH);
+            glUseProgram(0);
+
+            // The GPU is done with this frame's ring slots once it gets past the draw
+            sdfObjectBuffer.endFrame();
+            frameConstantsRing.fenceSlot();
+            if (params.cullingMode == CullingMode::TILES && tileRing.isCreated()) tileRing.fenceSlot();
+
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+            renderedSceneVersion = sceneVersion;
+            renderedConstants = frameConstants;
+            renderedProgram = drawProgram;
+            idleFrames = 0;
+        } else {
+            // Same scene as last frame, colorTexture still holds it: only the UI is redrawn on top
+            // (stay awake while picking reads are in flight so their results are not delayed by the wait,
+            // or while a specialized shader or variant builds, so it is picked up as soon as it is ready)
+            idleFrames = (pickReadback.hasPending() || generatedSceneBusy || shaderVariants.getPendingCount() > 0) ? 0 : idleFrames + 1;
+        }
+
+        if (pickRequested) {
+            gpuProfiler.beginPass(GPUProfiler::PICK_READBACK);
+            handlePickingRequest(display_w, display_h, params);
+            gpuProfiler.endPass(GPUProfiler::PICK_READBACK);
+        }
 
-        // Specify clear values for BOTH atttachments
-        glClearColor(params.clearColor[0], params.clearColor[1], params.clearColor[2],  1.0f);
-        GLint clearInt = -1;
-        glClearBufferiv(GL_COLOR, 1, &clearInt);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-
-        // --- Render Main SDF Scene ---
-        glUseProgram(shaderProgram);
-        // Set uniforms that are NOT part of the UBO
-        glUniform2f(u_resolutionLoc, (float)display_w, (float)display_h);
-        glUniform3fv(u_cameraPosLoc, 1, value_ptr(camera.Position));
-        glUniformMatrix3fv(u_cameraBasisLoc, 1, GL_FALSE, value_ptr(camera.GetBasisMatrix()));
-        glUniform1f(u_fovLoc, camera.Fov);
-        glUniform3fv(u_clearColorLoc, 1, params.clearColor);
-        glUniform1i(u_debugModeLoc, ui.getDebugMode());
-        glUniform1f(u_blendSmoothnessLoc, params.blendSmoothness);
-        int numObjectsToSend = std::min((int)sdfObjects.size(), MAX_SDF_OBJECTS);
-        glUniform1i(u_sdfCountLoc, numObjectsToSend);
-        int selectedObjectIndex = findObjectIndex(sdfObjects, selectedObjectId);
-        glUniform1i(u_selectedObjectIDLoc, selectedObjectIndex); // Send selected INDEX
-         // Check after setting main uniforms
-
-        // Draw the fullscreen quad
-        glDisable(GL_DEPTH_TEST);
-        glBindVertexArray(quadVAO);
-        glDrawArrays(GL_TRIANGLES, 0, 6);
-        glBindVertexArray(0);
-        glUseProgram(0);
-
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-        handlePickingRequest(display_w, display_h);
+        // -- Hover pre-highlight: re-read under the cursor when it moved or the frame changed --
+        if (params.hoverHighlight && !io.WantCaptureMouse && !inputResult.consumedMouse) {
+            static double lastHoverX = -1.0, lastHoverY = -1.0;
+            static uint64_t lastHoverSceneVersion = 0;
+            double mouseX, mouseY;
+            glfwGetCursorPos(window, &mouseX, &mouseY);
+            if (mouseX != lastHoverX || mouseY != lastHoverY || lastHoverSceneVersion != renderedSceneVersion) {
+                if (params.pickingMode == PickingMode::CPU_RAYCAST) {
+                    hoveredObjectIndex = cpuPick(static_cast<int>(mouseX), static_cast<int>(mouseY), display_w, display_h, params);
+                    lastHoverX = mouseX;
+                    lastHoverY = mouseY;
+                    lastHoverSceneVersion = renderedSceneVersion;
+                } else if (queuePickRead(static_cast<int>(mouseX), static_cast<int>(mouseY), display_w, display_h, PickReadback::Purpose::HOVER)) {
+                    lastHoverX = mouseX;
+                    lastHoverY = mouseY;
+                    lastHoverSceneVersion = renderedSceneVersion;
+                }
+            }
+        } else if (hoveredObjectIndex != -1 && (!params.hoverHighlight || io.WantCaptureMouse)) {
+            hoveredObjectIndex = -1;
+        }
         glCheckError();
 
         glBindFramebuffer(GL_READ_FRAMEBUFFER, renderFBO);
@@ -519,12 +899,18 @@ int main() {
         glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
         glCheckError();
         if (display_w > 0 && display_h > 0) {
+            gpuProfiler.beginPass(GPUProfiler::BLIT);
             glBlitFramebuffer(0, 0, display_w, display_h, 0, 0, display_w, display_h, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+            gpuProfiler.endPass(GPUProfiler::BLIT);
             glCheckError(); // Check right after blit
         }
 
         glBindFramebuffer(GL_FRAMEBUFFER, 0); // Unbind completely
 
+        if (ui.consumeFrameCaptureRequest()) {
+            saveFrameComparison(display_w, display_h, params, ui.getDebugMode(), selectedObjectIndex);
+        }
+
         // --- Update RAM Usage (Less Frequent) ---
         if (frameCounter++ % ramUpdateInterval == 0) { currentRSS = utility::getCurrentRSS(); }
 
@@ -534,20 +920,42 @@ int main() {
                       sdfObjects, selectedObjectId, nextSdfId, useGizmo);
 
         glViewport(0, 0, display_w, display_h);
+        gpuProfiler.beginPass(GPUProfiler::IMGUI);
         ui.render();
+        gpuProfiler.endPass(GPUProfiler::IMGUI);
+        gpuProfiler.endFrame();
 
         // --- Swap Buffers ---
         glfwMakeContextCurrent(window); // Ensure main context is current
         glfwSwapBuffers(window);
          // Final check for the frame
 
+        // --- Optional FPS cap ---
+        if (params.fpsCap > 0) {
+            auto framePeriod = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / params.fpsCap));
+            nextFrameDeadline += framePeriod;
+            auto now = std::chrono::steady_clock::now();
+            if (nextFrameDeadline < now) nextFrameDeadline = now; // Fell behind (or just woke up), don't try to catch up
+            utility::preciseSleepUntil(nextFrameDeadline);
+        } else {
+            nextFrameDeadline = std::chrono::steady_clock::now();
+        }
+
     }
 
     cout << "Cleaning up..." << endl;
     glDeleteVertexArrays(1, &quadVAO);
     glDeleteBuffers(1, &quadVBO);
     glDeleteProgram(shaderProgram);
-    glDeleteBuffers(1, &sdfDataUBO);
+    shaderVariants.destroy();
+    if (generatedProgram) glDeleteProgram(generatedProgram);
+    if (pendingGeneratedProgram.isActive()) shaderCache.cancelProgram(pendingGeneratedProgram);
+    gpuProfiler.destroy();
+    pickReadback.destroy();
+    sdfObjectBuffer.destroy();
+    frameConstantsRing.destroy();
+    tileRing.destroy();
+    if (csgSSBO) glDeleteBuffers(1, &csgSSBO);
 
     // Cleanup MRT FBO resources
     if (renderFBO) glDeleteFramebuffers(1, &renderFBO);
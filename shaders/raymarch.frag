@@ -6,42 +6,84 @@ layout (location = 1) out int out_ObjectID;
 
 in vec2 fragCoordScreen; // Input: Screen coords from vertex shader (-1 to 1)
 
-// Uniforms from CPU
-uniform vec2 u_resolution;          // Viewport resolution (width, height)
-uniform vec3 u_cameraPos;           //
-uniform mat3 u_cameraBasis;         // Stores camera's Right, Up, Forward vectors
-uniform float u_fov;                // Vertical field of view in degrees
-
-uniform int u_sdfCount;                         // Actual number of objects sent
-uniform int u_selectedObjectID;     // ID of the selected object (-1 for none)
-
-uniform float u_blendSmoothness;    // 'k' for smin (Global Blend)
-
-const int MAX_SDF_OBJECTS = 10;
-
-uniform vec3 u_clearColor;          // Background color
-uniform int u_debugMode;
+// Per-frame constants from CPU (matches FrameConstants in FrameConstants.h, one ring slot per frame)
+layout (std140, binding = 1) uniform FrameBlock {
+    mat3 u_cameraBasis;         // Stores camera's Right, Up, Forward vectors
+    vec3 u_cameraPos;           //
+    float u_fov;                // Vertical field of view in degrees
+    vec3 u_clearColor;          // Background color
+    float u_blendSmoothness;    // 'k' for smin (Global Blend)
+    vec2 u_resolution;          // Viewport resolution (width, height)
+    int u_sdfCount;             // Actual number of objects sent
+    int u_selectedObjectID;     // ID of the selected object (-1 for none)
+    int u_debugMode;
+    int u_bvhNodeCount;         // 0 = no BVH, evaluate every object
+    int u_cullingMode;          // CullingMode in AstralUI.h
+    int u_tileSize;             // Pixels per screen tile side
+    int u_tilesX;               // Screen tiles per row
+    int u_hoveredObjectID;      // Object index under the cursor (-1 for none)
+    int u_normalMethod;         // NormalMethod in AstralUI.h
+    float u_relaxation;         // Over-relaxation factor for sphere tracing (1 = plain steps)
+    int u_stepsCompare;         // Steps view: left half uses the original march
+    int u_maxSteps;             // Step budget per pixel (QualityPreset), at most MAX_STEPS
+    float u_coneScale;          // Hit epsilon in pixel footprints, 0 = fixed HIT_THRESHOLD
+    int u_csgLength;            // Instructions in CSGBlock, 0 = plain smooth union of every object
+    vec3 u_sceneBoundsMin;      // AABB of the whole scene, blend radius included
+    int u_lighting;             // 0 = unlit base color
+    vec3 u_sceneBoundsMax;      // (empty scene: max < min, every ray misses)
+    int u_selectionHighlight;   // 0 = no selection / hover tint
+};
 
 // Ray Marching Parameters
-const int MAX_STEPS = 500;
+const int MAX_STEPS = 500;          // Hard cap, u_maxSteps picks the budget below it
 const float MAX_DIST = 100.0;
-const float HIT_THRESHOLD = 0.001;
+const float HIT_THRESHOLD = 0.001;  // Smallest hit epsilon, used as-is close to the camera
+
+// u_cullingMode values
+const int CULLING_NONE = 0;
+const int CULLING_BVH = 1;
+const int CULLING_TILES = 2;
+
+// u_normalMethod values
+const int NORMAL_ANALYTIC = 0;
+const int NORMAL_FINITE_DIFFERENCE = 1;
+
+// --- Permutations (ShaderPermutations.h) ---
+// Each ASTRAL_* define fixes a mode at compile time, so a variant carries no code for the other modes.
+// Without the define the FrameBlock value is used: that is the uber shader drawn while a variant compiles
+#ifdef ASTRAL_DEBUG_MODE
+#define DEBUG_MODE ASTRAL_DEBUG_MODE
+#else
+#define DEBUG_MODE u_debugMode
+#endif
+#ifdef ASTRAL_LIGHTING
+#define LIGHTING_ENABLED (ASTRAL_LIGHTING != 0)
+#else
+#define LIGHTING_ENABLED (u_lighting != 0)
+#endif
+#ifdef ASTRAL_SELECTION_HIGHLIGHT
+#define SELECTION_HIGHLIGHT (ASTRAL_SELECTION_HIGHLIGHT != 0)
+#else
+#define SELECTION_HIGHLIGHT (u_selectionHighlight != 0)
+#endif
+#ifdef ASTRAL_NORMAL_METHOD
+#define NORMAL_METHOD ASTRAL_NORMAL_METHOD
+#else
+#define NORMAL_METHOD u_normalMethod
+#endif
+// Only the Basic and Normals views look at the normal, only Basic at the lit color
+#define NEEDS_NORMAL (DEBUG_MODE == 0 || DEBUG_MODE == 3)
+#define NEEDS_LIGHTING (DEBUG_MODE == 0)
+
+// BVH traversal limits, more candidates than this falls back to the full loop
+const int MAX_BVH_CANDIDATES = 32;
+const int BVH_STACK_SIZE = 32;
 
 
 // -- SDF FUNCTIONS --
-float sdBoxLocal(vec3 p, vec3 b) {
-    // Assumes p is already in local space, centered at origin
-    vec3 q = abs(p) -b ;
-    return length(max(q, 0.0)) + min(max(q.x, max(q.y, q.z)), 0.0);
-}
-
-float sdEllipsoidLocal(vec3 p, vec3 r) {
-    r = max(r,vec3(1e-6));
-    float k0 = length(p / r);
-    float k1 = length(p / (r *r));
-    if (k1 < 1e-7) return length(p) - length(r);
-    return k0 * (k0 - 1.0) / k1;
-}
+// sd<Name>Local / sdg<Name>Local of every SDFType plus evaluatePrimitive and primitiveBoundingRadius,
+// spliced in from SDFPrimitives.cpp when the shader is loaded
+// @PRIMITIVES@
 
 // Smooth Minimum function
 vec2 sminVerbose(float distA, float distB, float k) {
@@ -57,76 +99,370 @@ struct SDFResult {
     vec3 color; // Color of the closest surface
     int objectId; // ID of the object corresponding to 'dist'
     bool isSelected; // Was the closest object the selected one?
+    vec3 gradient; // World space gradient of 'dist', only filled by mapScene(p, true)
+    float lipschitz; // Largest Lipschitz bound of the objects blended in (dist / lipschitz never overshoots)
 };
 
-// --- FIX: UBO Struct Definition ---
+// --- Object Struct Definition (matches SDFObjectGPUData in SDFObject.h), 48 bytes ---
 struct SDFObjectGPUData {
-    mat4 inverseModelMatrix;
-    vec4 color;
-    vec4 paramsXYZ_type;
+    vec4 rotation;          // Unit quaternion (x, y, z, w), local -> world
+    vec3 position;          // World translation, also the bounding sphere center
+    uint colorLipschitz;    // RGBA8 unorm: rgb color, a = (Lipschitz bound - 1) / 2
+    vec3 parameters;        // Meaning per type, see SDFType.h
+    uint typeFlags;         // Bits 0-7: object type, bits 8-15: blend group, bits 16-31: rounding (unorm16)
 };
 
-// --- MODIFIED UBO DEFINITION ---
-layout (std140, binding = 0) uniform SDFBlock {
-    SDFObjectGPUData objects[MAX_SDF_OBJECTS];
+const uint OBJECT_TYPE_MASK = 0xFFu;
+const uint BLEND_GROUP_SHIFT = 8u;
+const uint BLEND_GROUP_MASK = 0xFFu;
+const uint ROUNDING_SHIFT = 16u;
+
+// What the primitive functions take: parameters, w = rounding
+vec4 primitiveParameters(SDFObjectGPUData obj) {
+    return vec4(obj.parameters, float(obj.typeFlags >> ROUNDING_SHIFT) / 65535.0);
+}
+
+// Rotates v by the unit quaternion q
+vec3 quatRotate(vec4 q, vec3 v) {
+    return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+
+// --- SSBO DEFINITION (std430, sized by the CPU, u_sdfCount entries are valid) ---
+layout (std430, binding = 0) readonly buffer SDFBlock {
+    SDFObjectGPUData objects[];
 } sdfBlockInstance;
 
 
-SDFResult mapTheWorld(vec3 p) {
+// --- BVH over the objects' world AABBs (matches BVHNode in SDFBVH.h) ---
+struct BVHNode {
+    vec3 boundsMin;
+    int leftOrObject;   // Inner node: left child, leaf: object index
+    vec3 boundsMax;
+    int right;          // Inner node: right child, leaf: -1
+};
+
+layout (std430, binding = 2) readonly buffer BVHBlock {
+    BVHNode nodes[];
+} bvhBlockInstance;
+
+float boxDistance(vec3 p, vec3 boundsMin, vec3 boundsMax) {
+    return length(max(max(boundsMin - p, p - boundsMax), 0.0));
+}
+
+// Collects the objects that can still change the blend at p, sorted by index so blend groups stay together.
+// An object is skipped when its bounds are more than the blend radius further away than some object's surface can be.
+// Returns -1 if there are too many candidates (caller evaluates everything instead).
+int gatherCandidates(vec3 p, float blendRadius, out int candidates[MAX_BVH_CANDIDATES]) {
+    float candidateDist[MAX_BVH_CANDIDATES];
+    int count = 0;
+    float bestUpperBound = 1e30; // Smallest upper bound on any object's distance so far
+
+    int stack[BVH_STACK_SIZE];
+    float stackDist[BVH_STACK_SIZE];
+    int stackSize = 0;
+    stack[0] = 0;
+    stackDist[0] = boxDistance(p, bvhBlockInstance.nodes[0].boundsMin, bvhBlockInstance.nodes[0].boundsMax);
+    stackSize = 1;
+
+    while (stackSize > 0) {
+        --stackSize;
+        if (stackDist[stackSize] - blendRadius > bestUpperBound) continue;
+        BVHNode node = bvhBlockInstance.nodes[stack[stackSize]];
+
+        if (node.right < 0) {
+            // Leaf: the surface is inside the box, so it is no further than the farthest corner
+            vec3 center = 0.5 * (node.boundsMin + node.boundsMax);
+            bestUpperBound = min(bestUpperBound, length(p - center) + length(node.boundsMax - center));
+            if (count == MAX_BVH_CANDIDATES) return -1;
+            candidates[count] = node.leftOrObject;
+            candidateDist[count] = stackDist[stackSize];
+            ++count;
+            continue;
+        }
+
+        if (stackSize + 2 > BVH_STACK_SIZE) return -1;
+        float leftDist = boxDistance(p, bvhBlockInstance.nodes[node.leftOrObject].boundsMin, bvhBlockInstance.nodes[node.leftOrObject].boundsMax);
+        float rightDist = boxDistance(p, bvhBlockInstance.nodes[node.right].boundsMin, bvhBlockInstance.nodes[node.right].boundsMax);
+        // Push the far child first so the near one is visited first and tightens the bound sooner
+        bool leftFirst = leftDist <= rightDist;
+        stack[stackSize] = leftFirst ? node.right : node.leftOrObject;
+        stackDist[stackSize] = leftFirst ? rightDist : leftDist;
+        ++stackSize;
+        stack[stackSize] = leftFirst ? node.leftOrObject : node.right;
+        stackDist[stackSize] = leftFirst ? leftDist : rightDist;
+        ++stackSize;
+    }
+
+    // Drop candidates gathered before the bound got tighter, then restore object order (insertion sort, count is small)
+    int kept = 0;
+    for (int i = 0; i < count; ++i) {
+        if (candidateDist[i] - blendRadius <= bestUpperBound) candidates[kept++] = candidates[i];
+    }
+    for (int i = 1; i < kept; ++i) {
+        int value = candidates[i];
+        int j = i - 1;
+        while (j >= 0 && candidates[j] > value) {
+            candidates[j + 1] = candidates[j];
+            --j;
+        }
+        candidates[j + 1] = value;
+    }
+    return kept;
+}
+
+// --- Per-tile object lists (matches TileBinner.h): (offset, count) per tile, then the object indices ---
+// (or, for CSG scenes, the tile's pruned tape: count instructions of two entries each)
+layout (std430, binding = 3) readonly buffer TileBlock {
+    uint tileData[];
+} tileBlockInstance;
+
+// This pixel's list, set once in main()
+int g_tileOffset = 0;
+int g_tileCount = 0;
+
+// --- Order independent smooth union (matches SDFEvaluator and SDFEvaluatorKernels.h) ---
+// Objects of one blend group merge through an exponential smooth minimum, nearest - ke * log(sum(exp((nearest - d) / ke))),
+// and the groups then combine with a hard min. The sum does not care in which order objects arrive, and an object more
+// than the blend radius (BLEND_RADIUS_SCALE * k) beyond the nearest one adds less than 2^-24 to it, so skipping it in
+// any culling mode leaves the float result as it is
+const float BLEND_EXP_SCALE = 0.36067376;   // ke = k / (4 ln 2): two touching objects bulge by k / 4, like the polynomial smin
+const float BLEND_RADIUS_SCALE = 6.0;       // 24 ln 2 * ke = 6k, where exp(-6k / ke) = 2^-24
+const float BLEND_MIN_K = 1e-6;             // k = 0 is a hard min, kept finite
+
+struct BlendGroup {
+    int id;             // Blend group being summed, -1 before the first object
+    float nearest;      // Distance of its nearest object so far, the sums below are relative to it
+    float weightSum;
+    vec3 color;         // Weighted sums
+    vec3 gradient;
+    float lipschitz;
+    float nearestLipschitz;
+    int objectId;       // Nearest object
+};
+
+BlendGroup openBlendGroup(int id) {
+    return BlendGroup(id, MAX_DIST, 0.0, vec3(0.0), vec3(0.0), 0.0, 1.0, -1);
+}
+
+// Hard min of the finished group into res. The bound is the nearest object's, or the weighted mean when that is larger
+void closeBlendGroup(inout SDFResult res, BlendGroup group, float k) {
+    if (group.objectId < 0) return;
+    float dist = group.nearest - max(k, BLEND_MIN_K) * BLEND_EXP_SCALE * log(group.weightSum);
+    if (dist < res.dist) {
+        res.dist = dist;
+        res.color = group.color / group.weightSum;
+        res.gradient = group.gradient / group.weightSum; // d/dd_i of the sum is its normalized weight
+        res.lipschitz = max(group.nearestLipschitz, group.lipschitz / group.weightSum);
+        res.objectId = group.objectId;
+    }
+}
+
+// Adds object 'i' of blend group groupId, closing the open group into res first when groupId starts a new one.
+// Shared by blendObject and the generated mapSceneGenerated
+void blendDistance(inout SDFResult res, inout BlendGroup group, int i, int groupId, float dist, vec3 gradient, vec3 color, float lipschitz, float k) {
+    if (groupId != group.id) {
+        closeBlendGroup(res, group, k);
+        group = openBlendGroup(groupId);
+    }
+    float ke = max(k, BLEND_MIN_K) * BLEND_EXP_SCALE;
+    if (dist < group.nearest) {
+        // New nearest object: the sums so far are rescaled to it
+        float scale = exp((dist - group.nearest) / ke);
+        group.weightSum = group.weightSum * scale + 1.0;
+        group.color = group.color * scale + color;
+        group.gradient = group.gradient * scale + gradient;
+        group.lipschitz = group.lipschitz * scale + lipschitz;
+        group.nearest = dist;
+        group.nearestLipschitz = lipschitz;
+        group.objectId = i;
+    } else {
+        float weight = exp((group.nearest - dist) / ke);
+        group.weightSum += weight;
+        group.color += weight * color;
+        group.gradient += weight * gradient;
+        group.lipschitz += weight * lipschitz;
+    }
+}
+
+// Object 'i' on its own: distance, color, Lipschitz bound and, with computeGradient, the world space gradient
+SDFResult evaluateObject(int i, vec3 p, bool computeGradient) {
+    // Get data for object 'i'
+    SDFObjectGPUData obj_i = sdfBlockInstance.objects[i];
+    uint objType_i = obj_i.typeFlags & OBJECT_TYPE_MASK;
+
+    vec4 colorLipschitz_i = unpackUnorm4x8(obj_i.colorLipschitz);
+    SDFResult res = SDFResult(MAX_DIST, colorLipschitz_i.rgb, i, false, vec3(0.0), 1.0 + 2.0 * colorLipschitz_i.a);
+
+    // Calculate distance to object 'i', the inverse rotation is the conjugate
+    vec3 pLocal_i = quatRotate(vec4(-obj_i.rotation.xyz, obj_i.rotation.w), p - obj_i.position);
+
+    // Objects are sorted by type within each blend group, so neighbouring iterations take the same case
+    vec4 distGrad = evaluatePrimitive(objType_i, pLocal_i, primitiveParameters(obj_i), computeGradient);
+    res.dist = distGrad.x;
+    if (computeGradient) {
+        // Back to world space: rigid transform, so the gradient just rotates with the object
+        res.gradient = quatRotate(obj_i.rotation, distGrad.yzw);
+    }
+    return res;
+}
+
+// Distance to object 'i' and blend it into its group, with its world space gradient when computeGradient is set
+void blendObject(inout SDFResult res, inout BlendGroup group, int i, vec3 p, float k, bool computeGradient) {
+    // Early out before the transform: the surface is at least as far as the bounding sphere, so once that is more
+    // than the blend radius beyond the nearest object (of the open group or a closed one) its weight is below 2^-24
+    // and it can not be the nearest of a group that wins the min
+    SDFObjectGPUData obj_i = sdfBlockInstance.objects[i];
+    float boundingRadius_i = primitiveBoundingRadius(obj_i.typeFlags & OBJECT_TYPE_MASK, primitiveParameters(obj_i));
+    if (length(p - obj_i.position) - boundingRadius_i > min(res.dist, group.nearest) + k * BLEND_RADIUS_SCALE) return;
+
+    SDFResult object = evaluateObject(i, p, computeGradient);
+    int groupId = int((obj_i.typeFlags >> BLEND_GROUP_SHIFT) & BLEND_GROUP_MASK);
+    blendDistance(res, group, i, groupId, object.dist, object.gradient, object.color, object.lipschitz, k);
+}
+
+// --- Scene CSG program (matches CSGInstruction in CSGTree.h): postfix, u_csgLength entries, 0 = plain union ---
+struct CSGInstruction {
+    uint opcode;        // Bits 0-7 opcode, bits 8-31 object index for CSG_PUSH
+    float smoothness;   // k of a binary op, 0 = sharp
+};
+
+layout (std430, binding = 4) readonly buffer CSGBlock {
+    CSGInstruction code[];
+} csgBlockInstance;
+
+const uint CSG_PUSH = 0u;
+const uint CSG_UNION = 1u;
+const uint CSG_SUBTRACT = 2u;
+const uint CSG_INTERSECT = 3u;
+const int CSG_STACK_SIZE = 8; // CSGTree::compile rejects deeper trees
+
+// Combines b (stack top) into a (below it). Intersection is max(a, b) = -min(-a, -b), subtraction is
+// max(a, -b); the cut surface keeps a's color and ID. Every op mixes the gradients, so the bound stays the larger one
+void csgCombine(inout SDFResult a, SDFResult b, uint opcode, float k) {
+    if (opcode == CSG_SUBTRACT) {
+        b.dist = -b.dist;
+        b.gradient = -b.gradient;
+    }
+    float side = (opcode == CSG_UNION) ? 1.0 : -1.0;
+    float h;
+    if (k > 0.0) {
+        vec2 blend_result = sminVerbose(side * a.dist, side * b.dist, k);
+        a.dist = side * blend_result.x;
+        h = blend_result.y;
+    } else {
+        h = (side * a.dist > side * b.dist) ? 1.0 : 0.0;
+        a.dist = mix(a.dist, b.dist, h);
+    }
+    a.gradient = mix(a.gradient, b.gradient, h);
+    a.lipschitz = max(a.lipschitz, b.lipschitz);
+    if (opcode != CSG_SUBTRACT) {
+        a.color = mix(a.color, b.color, h);
+        if (h > 0.5) {
+            a.objectId = b.objectId;
+        }
+    }
+}
+
+// Interprets the CSG program at p. With tile culling it runs this pixel's tape instead (TileBinner::binCSG): the
+// program pruned to what can change the result inside the tile, stored as (opcode, smoothness bits) pairs
+SDFResult runCSG(vec3 p, bool computeGradient) {
+    bool tileTape = (u_cullingMode == CULLING_TILES);
+    int tapeLength = tileTape ? g_tileCount : u_csgLength;
+    if (tapeLength == 0) { // The tile's rays never enter the scene bounds
+        return SDFResult(MAX_DIST, u_clearColor, -1, false, vec3(0.0), 1.0);
+    }
+
+    SDFResult stack[CSG_STACK_SIZE];
+    int top = 0;
+    for (int pc = 0; pc < tapeLength; ++pc) {
+        CSGInstruction instruction = tileTape
+            ? CSGInstruction(tileBlockInstance.tileData[g_tileOffset + 2 * pc], uintBitsToFloat(tileBlockInstance.tileData[g_tileOffset + 2 * pc + 1]))
+            : csgBlockInstance.code[pc];
+        uint opcode = instruction.opcode & 0xFFu;
+        if (opcode == CSG_PUSH) {
+            stack[top] = evaluateObject(int(instruction.opcode >> 8), p, computeGradient);
+            ++top;
+        } else {
+            --top;
+            csgCombine(stack[top - 1], stack[top], opcode, instruction.smoothness);
+        }
+    }
+    SDFResult res = stack[0];
+    res.isSelected = (res.objectId != -1 && res.objectId == u_selectedObjectID);
+    return res;
+}
+
+// Specialized scene from SceneCodegen (ASTRAL_GENERATED_SCENE builds only): mapSceneGenerated(p, computeGradient)
+// @SCENE_CODEGEN@
+
+// Scene distance, plus its gradient when computeGradient is set (one evaluation instead of six for the normal)
+SDFResult mapScene(vec3 p, bool computeGradient) {
+    if (u_csgLength > 0) {
+        return runCSG(p, computeGradient);
+    }
+#ifdef ASTRAL_GENERATED_SCENE
+    SDFResult res = mapSceneGenerated(p, computeGradient);
+    res.isSelected = (res.objectId != -1 && res.objectId == u_selectedObjectID);
+    return res;
+#else
     if (u_sdfCount == 0) { // Handle empty scene
-        return SDFResult(MAX_DIST, u_clearColor, -1, false);
+        return SDFResult(MAX_DIST, u_clearColor, -1, false, vec3(0.0), 1.0);
     }
 
-    // --- Initialize with the *first* object's data ---
     SDFResult res; // Use the result struct to hold intermediate values
     res.dist = MAX_DIST;
     res.color = u_clearColor;
     res.objectId = - 1;
+    res.gradient = vec3(0.0);
+    res.lipschitz = 1.0;
+    BlendGroup group = openBlendGroup(-1);
 
     float k = u_blendSmoothness; // Get blend factor from uniform
 
-    // --- Loop through the *rest* of the objects (start from i = 1) ---
-    for (int i = 0; i < u_sdfCount; ++i) {
-        // Get data for object 'i'
-        mat4 invTransform_i = sdfBlockInstance.objects[i].inverseModelMatrix; // no scale here
-        vec3 objColor_i = sdfBlockInstance.objects[i].color.rgb;
-        vec3 params_i = sdfBlockInstance.objects[i].paramsXYZ_type.xyz;
-        int objType_i = int(sdfBlockInstance.objects[i].paramsXYZ_type.w);
-
-        // Calculate distance to object 'i'
-        vec4 pLocal4_i = invTransform_i * vec4(p, 1.0);
-        vec3 pLocal_i = pLocal4_i.xyz / pLocal4_i.w;
-
-        float currentObjDist = MAX_DIST;
-        if (objType_i == 0) {
-            currentObjDist = sdEllipsoidLocal(pLocal_i, params_i);
-        }
-        else if (objType_i == 1) {
-            currentObjDist = sdBoxLocal(pLocal_i, params_i);
+    if (u_cullingMode == CULLING_TILES) {
+        // Only the objects whose screen bounds touch this pixel's tile
+        for (int c = 0; c < g_tileCount; ++c) {
+            blendObject(res, group, int(tileBlockInstance.tileData[g_tileOffset + c]), p, k, computeGradient);
         }
+        closeBlendGroup(res, group, k);
+        res.isSelected = (res.objectId != -1 && res.objectId == u_selectedObjectID);
+        return res;
+    }
 
-        // Combine with previos result if i > 0
-        if (i == 0) {
-            res.dist= currentObjDist;
-            res.color = objColor_i;
-            res.objectId = i;
-        } else {
-            vec2 blend_result = sminVerbose(res.dist, currentObjDist, k);
-            res.dist = blend_result.x;
-            res.color = mix(res.color, objColor_i, blend_result.y);
-            if (blend_result.y > 0.5) {
-                res.objectId = i;
-            }
+    // Only the objects near p, in their original order (which keeps each blend group's objects together)
+    int candidates[MAX_BVH_CANDIDATES];
+    int candidateCount = (u_cullingMode == CULLING_BVH && u_bvhNodeCount > 0) ? gatherCandidates(p, k * BLEND_RADIUS_SCALE, candidates) : -1;
+
+    if (candidateCount >= 0) {
+        for (int c = 0; c < candidateCount; ++c) {
+            blendObject(res, group, candidates[c], p, k, computeGradient);
+        }
+    } else {
+        for (int i = 0; i < u_sdfCount; ++i) {
+            blendObject(res, group, i, p, k, computeGradient);
         }
     }
+    closeBlendGroup(res, group, k);
 
     // Final check for selection highlight using the determined closestObjectId
     res.isSelected = (res.objectId != -1 && res.objectId == u_selectedObjectID);
     return res; // Return the result with blended distance and color
+#endif
+}
+
+SDFResult mapTheWorld(vec3 p) {
+    return mapScene(p, false);
 }
 
 // -- Calculate Normal --
 vec3 calcNormal(vec3 p, float t) {
+    if (NORMAL_METHOD == NORMAL_ANALYTIC) {
+        vec3 gradient = mapScene(p, true).gradient;
+        // Zero gradient (exactly on a box edge or centre) falls through to the differences below
+        if (dot(gradient, gradient) > 1e-12) return normalize(gradient);
+    }
+
+    // Finite differences, six scene evaluations (kept to validate the analytic path)
 
     float epsilon = max(t * 0.0005, HIT_THRESHOLD * 0.1); // Don't let epsilon become too small
 
@@ -154,16 +490,22 @@ vec3 getRayDir(vec2 screenPos, float fov){
 }
 
 // -- Simple Lambertian Diffuse lighting + Selection Highlight --
-vec3 applyLighting(vec3 hitPos, vec3 normal, vec3 baseColor, bool isSelected) {
-    vec3 lightDir = normalize(vec3(0.8, -1.0, 0.5));
-    float diffuse = max(0.0, dot(normal, lightDir));
-    vec3 ambient = vec3(0.1) * baseColor;
-
-    vec3 litColorWithHighlight  = ambient + baseColor * diffuse;
+vec3 applyLighting(vec3 hitPos, vec3 normal, vec3 baseColor, bool isSelected, bool isHovered) {
+    vec3 litColorWithHighlight = baseColor;
+    if (LIGHTING_ENABLED) {
+        vec3 lightDir = normalize(vec3(0.8, -1.0, 0.5));
+        float diffuse = max(0.0, dot(normal, lightDir));
+        vec3 ambient = vec3(0.1) * baseColor;
+        litColorWithHighlight = ambient + baseColor * diffuse;
+    }
 
     // Add selection highlight
-    if (isSelected) {
-        litColorWithHighlight += vec3(0.2, 0.2, 0.0); // Slightly stronger yellow highlight
+    if (SELECTION_HIGHLIGHT) {
+        if (isSelected) {
+            litColorWithHighlight += vec3(0.2, 0.2, 0.0); // Slightly stronger yellow highlight
+        } else if (isHovered) {
+            litColorWithHighlight += vec3(0.08, 0.08, 0.08); // Faint pre-highlight under the cursor
+        }
     }
 
     return clamp(litColorWithHighlight , 0.0, 1.0);
@@ -177,60 +519,124 @@ struct RayMarchResult {
     float finalDist;    // Distance from origin along ray to the hit point
     int hitObjectIndex;    // ID of the object hit
     bool hitSelected;   // Was the hit object selected?
+    vec3 normal;        // Surface normal at the hit (zero on a miss)
 };
 
 
+// Entry and exit distance of the ray through the scene bounds, entry > exit when it misses
+vec2 intersectSceneBounds(vec3 ro, vec3 rd) {
+    vec3 invDir = 1.0 / (rd + vec3(equal(rd, vec3(0.0))) * 1e-8); // No 0 * inf on axis-aligned rays
+    vec3 t0 = (u_sceneBoundsMin - ro) * invDir;
+    vec3 t1 = (u_sceneBoundsMax - ro) * invDir;
+    vec3 tNear = min(t0, t1);
+    vec3 tFar = max(t0, t1);
+    float entry = max(max(tNear.x, tNear.y), max(tNear.z, 0.0));
+    float exit = min(min(tFar.x, tFar.y), tFar.z);
+    return vec2(entry, exit);
+}
+
 // -- Ray Marching Function --
-RayMarchResult rayMarch(vec3 ro, vec3 rd){
+// Over-relaxed sphere tracing (Keinert et al. 2014): steps are scaled by the Lipschitz bound and stretched by
+// u_relaxation. When the empty spheres at two consecutive points stop overlapping (or the point is inside)
+// the relaxed step may have jumped over a surface, so the march goes back to the plain step, takes it
+// without relaxation, then relaxes again.
+// The hit test is cone based: a surface closer than the pixel's footprint at that distance (times
+// u_coneScale) can't be resolved any better, so marching further only costs steps.
+// Marching starts where the ray enters the scene bounds and gives up where it leaves them, so background
+// pixels cost no steps at all.
+// enhanced = false is the original march (fixed 0.9 step, threshold, budget and range), kept for the Steps comparison view.
+// On a miss, steps is how many scene evaluations it took.
+RayMarchResult rayMarch(vec3 ro, vec3 rd, bool enhanced){
     float totalDist = 0.0;
-    for (int i = 0; i < MAX_STEPS; i++){
+    float maxDist = MAX_DIST;
+    if (enhanced) {
+        vec2 range = intersectSceneBounds(ro, rd);
+        if (range.x > range.y) {
+            return RayMarchResult(u_clearColor, 0, false, MAX_DIST, -1, false, vec3(0.0));
+        }
+        totalDist = range.x;
+        maxDist = min(MAX_DIST, range.y);
+    }
+    int steps = 0;
+    float relaxation = enhanced ? max(u_relaxation, 1.0) : 1.0;
+    float omega = relaxation;
+    float prevRadius = 0.0; // Empty sphere radius at the previous point
+    float stepDist = 0.0;   // Last step taken
+    int maxSteps = enhanced ? min(u_maxSteps, MAX_STEPS) : MAX_STEPS;
+    // Angle covered by one pixel, the footprint at distance t is t * pixelAngle
+    float pixelAngle = 2.0 * tan(radians(u_fov * 0.5)) / u_resolution.y;
+    float coneSlope = enhanced ? pixelAngle * u_coneScale : 0.0;
+    for (int i = 0; i < maxSteps; i++){
+        steps = i + 1;
         vec3 p = ro + rd * totalDist;
         SDFResult scene = mapTheWorld(p); // Get distance and color
+        float radius = enhanced ? scene.dist / scene.lipschitz : scene.dist * 0.90;
+
+        if (omega > 1.0 && radius + prevRadius < stepDist) {
+            // Overshoot: back to the end of the unrelaxed step, which is inside the previous sphere
+            totalDist += prevRadius - stepDist;
+            stepDist = prevRadius;
+            omega = 1.0;
+            continue;
+        }
 
-        if (scene.dist < HIT_THRESHOLD){
-            // Hit! Calculate Lighting
-            vec3 normal = calcNormal(p, totalDist);
-
-           vec3 litColor = applyLighting(p, normal, scene.color, scene.isSelected);
-            return RayMarchResult(litColor, i + 1, true, totalDist, scene.objectId, scene.isSelected);
+        if (scene.dist < max(HIT_THRESHOLD, totalDist * coneSlope)){
+            // Hit! Calculate Lighting (skipped by the debug views that don't show it)
+            vec3 normal = NEEDS_NORMAL ? calcNormal(p, totalDist) : vec3(0.0);
+            vec3 litColor = scene.color;
+            if (NEEDS_LIGHTING) {
+                bool isHovered = (scene.objectId != -1 && scene.objectId == u_hoveredObjectID);
+                litColor = applyLighting(p, normal, scene.color, scene.isSelected, isHovered);
+            }
+            return RayMarchResult(litColor, i + 1, true, totalDist, scene.objectId, scene.isSelected, normal);
         }
 
-        if (totalDist > MAX_DIST){
+        if (totalDist > maxDist){
             break;
         }
 
-        float stepDist = max(HIT_THRESHOLD * 0.1, scene.dist * 0.90);
+        prevRadius = radius;
+        stepDist = max(HIT_THRESHOLD * 0.1, radius * omega);
         totalDist += stepDist;
+        omega = relaxation;
     }
     // Missed
-    return RayMarchResult(u_clearColor, MAX_STEPS, false, totalDist, -1, false);
+    return RayMarchResult(u_clearColor, steps, false, totalDist, -1, false, vec3(0.0));
 }
 
 void main()
 {
+    if (u_cullingMode == CULLING_TILES) {
+        ivec2 tile = ivec2(gl_FragCoord.xy) / u_tileSize;
+        int tileIndex = tile.y * u_tilesX + tile.x;
+        g_tileOffset = int(tileBlockInstance.tileData[2 * tileIndex]);
+        g_tileCount = int(tileBlockInstance.tileData[2 * tileIndex + 1]);
+    }
+
     // Calculate ray origin (ro) and direction (rd)
     vec3 ro = u_cameraPos;
     vec3 rd = getRayDir(fragCoordScreen, u_fov);
 
-    // Perform ray marching
-    RayMarchResult result = rayMarch(ro, rd);
+    // Perform ray marching (the Steps comparison marches the left half the old way)
+    bool compareHalf = (DEBUG_MODE == 1 && u_stepsCompare != 0 && gl_FragCoord.x < 0.5 * u_resolution.x);
+    RayMarchResult result = rayMarch(ro, rd, !compareHalf);
 
     vec3 finalRenderColor;
 
-    switch (u_debugMode) {
+    switch (DEBUG_MODE) {
         case 1: // Show Steps
         float stepsNormalized = float(result.steps) / float(MAX_STEPS);
         finalRenderColor = vec3(stepsNormalized);
+        if (u_stepsCompare != 0 && abs(gl_FragCoord.x - 0.5 * u_resolution.x) < 1.0) {
+            finalRenderColor = vec3(1.0, 0.0, 0.0); // Divider
+        }
         break;
         case 2: // Show Hit/Miss
         finalRenderColor = result.hit ? vec3(1.0) : vec3(0.0); // White for hit black for miss
         break;
         case 3: // Show Normals
         if (result.hit){
-            // Recalculate normal at the approximate hit position
-            vec3 hitPos = ro + rd * result.finalDist;
-            vec3 normal = calcNormal(hitPos,result.finalDist);
-            finalRenderColor = normal * 0.5 + 0.5; // Map normal range [-1,1] to [0,1] for color
+            finalRenderColor = result.normal * 0.5 + 0.5; // Map normal range [-1,1] to [0,1] for color
         } else {
             finalRenderColor = vec3(0.0);
         }
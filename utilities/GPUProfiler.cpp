@@ -0,0 +1,121 @@
+//
+// Timestamp query ring
+//
+
+#include "GPUProfiler.h"
+#include <algorithm>
+
+GPUProfiler::~GPUProfiler() {
+    destroy();
+}
+
+void GPUProfiler::init() {
+    if (m_initialized) return;
+    for (FrameQueries& frame : m_frames) {
+        glGenQueries(static_cast<GLsizei>(frame.queries.size()), frame.queries.data());
+        frame.used.fill(false);
+        frame.pending = false;
+    }
+    for (auto& history : m_history) history.reserve(HISTORY_SIZE);
+    m_initialized = true;
+}
+
+void GPUProfiler::destroy() {
+    if (!m_initialized) return;
+    for (FrameQueries& frame : m_frames) {
+        glDeleteQueries(static_cast<GLsizei>(frame.queries.size()), frame.queries.data());
+    }
+    m_initialized = false;
+}
+
+void GPUProfiler::collect(FrameQueries& frame) {
+    if (!frame.pending) return;
+    frame.pending = false;
+
+    // The last query written is the frame end, once it is available every earlier one is too
+    GLuint available = GL_FALSE;
+    glGetQueryObjectuiv(frame.queries[FRAME * 2 + 1], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) {
+        ++m_droppedFrames; // Never block, just lose this frame's samples
+        return;
+    }
+
+    for (int pass = 0; pass < PASS_COUNT; ++pass) {
+        if (!frame.used[pass]) continue;
+        GLuint64 begin = 0, end = 0;
+        glGetQueryObjectui64v(frame.queries[pass * 2], GL_QUERY_RESULT, &begin);
+        glGetQueryObjectui64v(frame.queries[pass * 2 + 1], GL_QUERY_RESULT, &end);
+        float ms = static_cast<float>(static_cast<double>(end - begin) / 1.0e6);
+
+        std::vector<float>& history = m_history[pass];
+        if (static_cast<int>(history.size()) < HISTORY_SIZE) {
+            history.push_back(ms);
+        } else {
+            history[m_historyNext[pass]] = ms;
+        }
+        m_historyNext[pass] = (m_historyNext[pass] + 1) % HISTORY_SIZE;
+        m_lastMs[pass] = ms;
+    }
+}
+
+void GPUProfiler::beginFrame() {
+    if (!m_initialized) return;
+    m_frameIndex = (m_frameIndex + 1) % FRAME_LATENCY;
+    FrameQueries& frame = m_frames[m_frameIndex];
+    collect(frame); // Written FRAME_LATENCY frames ago
+
+    frame.used.fill(false);
+    beginPass(FRAME);
+}
+
+void GPUProfiler::endFrame() {
+    if (!m_initialized) return;
+    endPass(FRAME);
+    m_frames[m_frameIndex].pending = true;
+}
+
+void GPUProfiler::beginPass(Pass pass) {
+    if (!m_initialized) return;
+    FrameQueries& frame = m_frames[m_frameIndex];
+    glQueryCounter(frame.queries[pass * 2], GL_TIMESTAMP);
+    frame.used[pass] = true;
+}
+
+void GPUProfiler::endPass(Pass pass) {
+    if (!m_initialized) return;
+    glQueryCounter(m_frames[m_frameIndex].queries[pass * 2 + 1], GL_TIMESTAMP);
+}
+
+GPUProfiler::PassStats GPUProfiler::getStats(Pass pass) const {
+    PassStats stats;
+    const std::vector<float>& history = m_history[pass];
+    if (history.empty()) return stats;
+
+    std::vector<float> sorted = history;
+    std::sort(sorted.begin(), sorted.end());
+    auto percentile = [&](float p) {
+        size_t index = static_cast<size_t>(p * static_cast<float>(sorted.size() - 1) + 0.5f);
+        return sorted[std::min(index, sorted.size() - 1)];
+    };
+
+    float sum = 0.0f;
+    for (float ms : sorted) sum += ms;
+    stats.lastMs = m_lastMs[pass];
+    stats.averageMs = sum / static_cast<float>(sorted.size());
+    stats.p50Ms = percentile(0.50f);
+    stats.p95Ms = percentile(0.95f);
+    stats.p99Ms = percentile(0.99f);
+    stats.sampleCount = static_cast<int>(sorted.size());
+    return stats;
+}
+
+const char* GPUProfiler::getPassName(Pass pass) {
+    switch (pass) {
+        case FRAME: return "Frame";
+        case RAYMARCH: return "Raymarch";
+        case PICK_READBACK: return "Pick Readback";
+        case BLIT: return "Blit";
+        case IMGUI: return "ImGui";
+        default: return "Unknown";
+    }
+}
@@ -0,0 +1,73 @@
+//
+// GPU timing per render pass with GL_TIMESTAMP queries.
+// Queries go into a ring of FRAME_LATENCY frames and are only read once GL_QUERY_RESULT_AVAILABLE says so,
+// so the CPU never waits for the GPU. Keeps a rolling window of samples per pass for averages and percentiles.
+//
+#pragma once
+#include <glad/glad.h>
+#include <array>
+#include <vector>
+
+class GPUProfiler {
+public:
+    enum Pass {
+        FRAME = 0,      // beginFrame() to endFrame()
+        RAYMARCH,
+        PICK_READBACK,
+        BLIT,
+        IMGUI,
+        PASS_COUNT
+    };
+
+    struct PassStats {
+        float lastMs = 0.0f;
+        float averageMs = 0.0f;
+        float p50Ms = 0.0f;
+        float p95Ms = 0.0f;
+        float p99Ms = 0.0f;
+        int sampleCount = 0;
+    };
+
+    static constexpr int FRAME_LATENCY = 4;   // Frames a query may stay in flight
+    static constexpr int HISTORY_SIZE = 240;  // Samples per pass in the rolling window
+
+    GPUProfiler() = default;
+    ~GPUProfiler();
+
+    GPUProfiler(const GPUProfiler&) = delete;
+    GPUProfiler& operator=(const GPUProfiler&) = delete;
+
+    void init();
+    void destroy();
+
+    // Collects the oldest frame's results (if ready) and starts timing a new one
+    void beginFrame();
+    void endFrame();
+
+    // Passes may be skipped in a frame (e.g. no raymarch while the scene is cached)
+    void beginPass(Pass pass);
+    void endPass(Pass pass);
+
+    PassStats getStats(Pass pass) const;
+    static const char* getPassName(Pass pass);
+    int getDroppedFrames() const { return m_droppedFrames; } // Frames whose results were still not ready after FRAME_LATENCY frames
+
+private:
+    struct FrameQueries {
+        std::array<GLuint, PASS_COUNT * 2> queries{};  // Begin / end timestamp per pass
+        std::array<bool, PASS_COUNT> used{};
+        bool pending = false;
+    };
+
+    void collect(FrameQueries& frame);
+
+    std::array<FrameQueries, FRAME_LATENCY> m_frames;
+    int m_frameIndex = 0;
+    bool m_initialized = false;
+    int m_droppedFrames = 0;
+
+    // Rolling window per pass
+    std::array<std::vector<float>, PASS_COUNT> m_history;
+    std::array<int, PASS_COUNT> m_historyNext{};
+    std::array<float, PASS_COUNT> m_lastMs{};
+};
@@ -0,0 +1,278 @@
+//
+// Program binary cache
+//
+
+#include "ShaderCache.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+using namespace std;
+
+// --- Shader Compile ---
+GLuint compileShader(GLenum type, const std::string& source) {
+    GLuint shader = glCreateShader(type);
+    const char* src = source.c_str();
+    glShaderSource(shader, 1, &src, NULL);
+    glCompileShader(shader);
+    GLint success; GLchar infoLog[1024];
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    glGetShaderInfoLog(shader, 1024, NULL, infoLog);
+    if (!success) {
+        cerr << "ERROR::SHADER::COMPILATION_FAILED (" << (type == GL_VERTEX_SHADER ? "VERTEX" : "FRAGMENT") << ")\n" << infoLog << endl;
+        glDeleteShader(shader); return 0;
+    } else if (strlen(infoLog) > 0) { cout << "Shader Compile Log (" << (type == GL_VERTEX_SHADER ? "VERTEX" : "FRAGMENT") << " - Success with messages):\n" << infoLog << endl;}
+    return shader;
+}
+
+// --- Link Program ---
+GLuint linkProgram(GLuint vertexShader, GLuint fragmentShader) {
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vertexShader);
+    glAttachShader(program, fragmentShader);
+    glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE); // Allow glGetProgramBinary
+    glLinkProgram(program);  // Check right after a link
+
+    GLint success; GLchar infoLog[1024];
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    glGetProgramInfoLog(program, 1024, NULL, infoLog);
+    if (!success) {
+        cerr << "ERROR::PROGRAM::LINKING_FAILED\n" << infoLog << endl;
+        glDeleteProgram(program); return 0;
+    } else if (strlen(infoLog) > 0) { cout << "Program (ID: " << program << ") Link Log (Success with messages):\n" << infoLog << endl; }
+
+    // Detach shaders immediately after a successful link
+    glDetachShader(program, vertexShader);
+    glDetachShader(program, fragmentShader);
+
+    return program;
+}
+
+std::string injectDefines(const std::string& source, const std::string& defines) {
+    if (defines.empty()) return source;
+    size_t versionPos = source.find("#version");
+    if (versionPos == std::string::npos) return defines + source;
+    size_t lineEnd = source.find('\n', versionPos);
+    if (lineEnd == std::string::npos) return source + "\n" + defines;
+    return source.substr(0, lineEnd + 1) + defines + source.substr(lineEnd + 1);
+}
+
+// --- Cache ---
+namespace {
+    constexpr uint32_t CACHE_MAGIC = 0x43505341; // "ASPC"
+    constexpr uint32_t CACHE_VERSION = 1;
+
+    struct CacheHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t key;
+        uint32_t binaryFormat;
+        uint32_t binaryLength;
+    };
+
+    // FNV-1a, 64 bit
+    void hashBytes(uint64_t& hash, const void* data, size_t size) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+    }
+
+    void hashString(uint64_t& hash, const char* text) {
+        if (!text) text = "";
+        hashBytes(hash, text, strlen(text) + 1); // Include the terminator so "ab"+"c" != "a"+"bc"
+    }
+}
+
+ShaderCache::ShaderCache(std::string cacheDirectory) : m_cacheDirectory(std::move(cacheDirectory)) {
+    GLint formatCount = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+    m_binarySupported = (formatCount > 0 && glGetProgramBinary != NULL && glProgramBinary != NULL);
+    if (!m_binarySupported) {
+        cout << "Shader cache disabled: the driver exposes no program binary formats." << endl;
+    }
+
+    // The default MAX_SHADER_COMPILER_THREADS (0xFFFFFFFF) already lets the driver pick the thread count
+    GLint extensionCount = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+    for (GLint i = 0; i < extensionCount && !m_parallelCompileSupported; ++i) {
+        const char* name = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+        if (name && (strcmp(name, "GL_KHR_parallel_shader_compile") == 0 || strcmp(name, "GL_ARB_parallel_shader_compile") == 0)) {
+            m_parallelCompileSupported = true;
+        }
+    }
+    cout << "Parallel shader compile " << (m_parallelCompileSupported ? "available." : "not available, background builds will block.") << endl;
+}
+
+uint64_t ShaderCache::computeKey(const std::string& vertexSource, const std::string& fragmentSource, const std::string& defines) const {
+    uint64_t hash = 14695981039346656037ull;
+    hashBytes(hash, &CACHE_VERSION, sizeof(CACHE_VERSION));
+    hashString(hash, vertexSource.c_str());
+    hashString(hash, fragmentSource.c_str());
+    hashString(hash, defines.c_str());
+    hashString(hash, reinterpret_cast<const char*>(glGetString(GL_VENDOR)));
+    hashString(hash, reinterpret_cast<const char*>(glGetString(GL_RENDERER)));
+    hashString(hash, reinterpret_cast<const char*>(glGetString(GL_VERSION))); // Carries the driver version
+    return hash;
+}
+
+std::string ShaderCache::getCachePath(uint64_t key) const {
+    std::ostringstream name;
+    name << std::hex << key << ".bin";
+    return (std::filesystem::path(m_cacheDirectory) / name.str()).string();
+}
+
+GLuint ShaderCache::loadBinary(uint64_t key) const {
+    std::ifstream file(getCachePath(key), std::ios::binary);
+    if (!file.is_open()) return 0;
+
+    CacheHeader header{};
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!file || header.magic != CACHE_MAGIC || header.version != CACHE_VERSION || header.key != key || header.binaryLength == 0) {
+        return 0;
+    }
+    std::vector<char> binary(header.binaryLength);
+    file.read(binary.data(), static_cast<std::streamsize>(binary.size()));
+    if (!file) return 0;
+
+    GLuint program = glCreateProgram();
+    glProgramBinary(program, header.binaryFormat, binary.data(), static_cast<GLsizei>(binary.size()));
+    GLint success = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success) {
+        // The driver can reject its own old binaries (e.g. after an update with the same version string)
+        cout << "Cached program binary rejected by the driver, recompiling." << endl;
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+void ShaderCache::storeBinary(uint64_t key, GLuint program) const {
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) return;
+
+    std::vector<char> binary(length);
+    GLenum binaryFormat = 0;
+    glGetProgramBinary(program, length, &length, &binaryFormat, binary.data());
+    if (length <= 0) return;
+
+    std::error_code error;
+    std::filesystem::create_directories(m_cacheDirectory, error);
+    std::ofstream file(getCachePath(key), std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        cerr << "ERROR::SHADER_CACHE::FILE_NOT_SUCCESSFULLY_WRITTEN " << getCachePath(key) << endl;
+        return;
+    }
+    CacheHeader header{CACHE_MAGIC, CACHE_VERSION, key, binaryFormat, static_cast<uint32_t>(length)};
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(binary.data(), length);
+}
+
+GLuint ShaderCache::loadProgram(const std::string& vertexSource, const std::string& fragmentSource, const std::string& defines) {
+    m_lastLoadCached = false;
+    const uint64_t key = computeKey(vertexSource, fragmentSource, defines);
+
+    if (m_binarySupported) {
+        if (GLuint program = loadBinary(key)) {
+            m_lastLoadCached = true;
+            return program;
+        }
+    }
+
+    GLuint vertexShader = compileShader(GL_VERTEX_SHADER, injectDefines(vertexSource, defines));
+    GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, injectDefines(fragmentSource, defines));
+    GLuint program = 0;
+    if (vertexShader && fragmentShader) {
+        program = linkProgram(vertexShader, fragmentShader);
+    }
+    if (vertexShader) glDeleteShader(vertexShader);
+    if (fragmentShader) glDeleteShader(fragmentShader);
+
+    if (program && m_binarySupported) storeBinary(key, program);
+    return program;
+}
+
+// --- Background builds ---
+PendingProgram ShaderCache::beginProgram(const std::string& vertexSource, const std::string& fragmentSource, const std::string& defines) {
+    PendingProgram pending;
+    pending.key = computeKey(vertexSource, fragmentSource, defines);
+
+    if (m_binarySupported) {
+        if (GLuint program = loadBinary(pending.key)) {
+            pending.program = program;
+            pending.fromCache = true;
+            return pending;
+        }
+    }
+
+    // Only issue the work here: asking for a status would wait for the driver
+    std::string vertexText = injectDefines(vertexSource, defines);
+    std::string fragmentText = injectDefines(fragmentSource, defines);
+    const char* vertexSrc = vertexText.c_str();
+    const char* fragmentSrc = fragmentText.c_str();
+    pending.vertexShader = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(pending.vertexShader, 1, &vertexSrc, NULL);
+    glCompileShader(pending.vertexShader);
+    pending.fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(pending.fragmentShader, 1, &fragmentSrc, NULL);
+    glCompileShader(pending.fragmentShader);
+
+    pending.program = glCreateProgram();
+    glAttachShader(pending.program, pending.vertexShader);
+    glAttachShader(pending.program, pending.fragmentShader);
+    glProgramParameteri(pending.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    glLinkProgram(pending.program);
+    return pending;
+}
+
+bool ShaderCache::isProgramReady(const PendingProgram& pending) const {
+    if (!pending.isActive() || pending.fromCache || !m_parallelCompileSupported) return true;
+    GLint complete = GL_FALSE;
+    glGetProgramiv(pending.program, GL_COMPLETION_STATUS_KHR, &complete);
+    return complete == GL_TRUE;
+}
+
+GLuint ShaderCache::finishProgram(PendingProgram& pending) {
+    GLuint program = pending.program;
+    if (program && !pending.fromCache) {
+        GLint success = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if (!success) {
+            GLchar infoLog[1024];
+            const GLuint shaders[2] = { pending.vertexShader, pending.fragmentShader };
+            for (GLuint shader : shaders) {
+                GLint compiled = GL_FALSE;
+                glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+                if (!compiled) {
+                    glGetShaderInfoLog(shader, 1024, NULL, infoLog);
+                    cerr << "ERROR::SHADER::COMPILATION_FAILED (" << (shader == pending.vertexShader ? "VERTEX" : "FRAGMENT") << ")\n" << infoLog << endl;
+                }
+            }
+            glGetProgramInfoLog(program, 1024, NULL, infoLog);
+            cerr << "ERROR::PROGRAM::LINKING_FAILED\n" << infoLog << endl;
+            glDeleteProgram(program);
+            program = 0;
+        } else {
+            glDetachShader(program, pending.vertexShader);
+            glDetachShader(program, pending.fragmentShader);
+            if (m_binarySupported) storeBinary(pending.key, program);
+        }
+    }
+    if (pending.vertexShader) glDeleteShader(pending.vertexShader);
+    if (pending.fragmentShader) glDeleteShader(pending.fragmentShader);
+    pending = PendingProgram{};
+    return program;
+}
+
+void ShaderCache::cancelProgram(PendingProgram& pending) {
+    if (pending.program) glDeleteProgram(pending.program);
+    if (pending.vertexShader) glDeleteShader(pending.vertexShader);
+    if (pending.fragmentShader) glDeleteShader(pending.fragmentShader);
+    pending = PendingProgram{};
+}
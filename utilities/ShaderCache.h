@@ -0,0 +1,65 @@
+//
+// Shader compile / link helpers and an on-disk cache of linked program binaries.
+// A cached binary is keyed by the shader sources, the injected defines and the GL renderer / driver version,
+// so editing a shader or updating the driver simply misses the cache and compiles again.
+//
+#pragma once
+#include <glad/glad.h>
+#include <cstdint>
+#include <string>
+
+GLuint compileShader(GLenum type, const std::string& source);
+GLuint linkProgram(GLuint vertexShader, GLuint fragmentShader);
+
+// GL_KHR_parallel_shader_compile (same value as the ARB token), missing from the bundled glad
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+// Inserts the define block right after the #version line (GLSL requires #version first)
+std::string injectDefines(const std::string& source, const std::string& defines);
+
+// A program whose compile and link were issued but not checked yet, see ShaderCache::beginProgram
+struct PendingProgram {
+    GLuint program = 0;
+    GLuint vertexShader = 0;
+    GLuint fragmentShader = 0;
+    uint64_t key = 0;
+    bool fromCache = false;
+
+    bool isActive() const { return program != 0; }
+};
+
+class ShaderCache {
+public:
+    explicit ShaderCache(std::string cacheDirectory = "shader_cache");
+
+    // Linked program for the sources, restored from disk when possible, compiled (and stored) otherwise.
+    // defines is GLSL text such as "#define ASTRAL_FOO 1\n", injected into both stages. Returns 0 on failure
+    GLuint loadProgram(const std::string& vertexSource, const std::string& fragmentSource, const std::string& defines = "");
+
+    bool wasLastLoadCached() const { return m_lastLoadCached; }
+
+    // Same as loadProgram without waiting for the driver: the compile runs on its threads when
+    // GL_KHR_parallel_shader_compile is available. Poll isProgramReady once per frame, then finishProgram
+    PendingProgram beginProgram(const std::string& vertexSource, const std::string& fragmentSource, const std::string& defines = "");
+    // Always true without the extension (finishProgram then blocks until the driver is done)
+    bool isProgramReady(const PendingProgram& pending) const;
+    // Checks the link (printing the logs on failure) and stores the binary. Returns the program or 0, resets pending
+    GLuint finishProgram(PendingProgram& pending);
+    // Drops a build that is no longer wanted
+    void cancelProgram(PendingProgram& pending);
+
+    bool isParallelCompileSupported() const { return m_parallelCompileSupported; }
+
+private:
+    uint64_t computeKey(const std::string& vertexSource, const std::string& fragmentSource, const std::string& defines) const;
+    std::string getCachePath(uint64_t key) const;
+    GLuint loadBinary(uint64_t key) const;
+    void storeBinary(uint64_t key, GLuint program) const;
+
+    std::string m_cacheDirectory;
+    bool m_binarySupported = false;
+    bool m_lastLoadCached = false;
+    bool m_parallelCompileSupported = false;
+};
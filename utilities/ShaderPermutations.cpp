@@ -0,0 +1,101 @@
+//
+// Shader permutation cache
+//
+
+#include "ShaderPermutations.h"
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+
+uint32_t ShaderPermutation::getKey() const {
+    uint32_t key = static_cast<uint32_t>(std::clamp(debugMode, 0, DEBUG_MODE_COUNT - 1));
+    key = key * 2 + (lighting ? 1 : 0);
+    key = key * 2 + (selectionHighlight ? 1 : 0);
+    key = key * NORMAL_METHOD_COUNT + static_cast<uint32_t>(std::clamp(normalMethod, 0, NORMAL_METHOD_COUNT - 1));
+    return key;
+}
+
+ShaderPermutation ShaderPermutation::fromKey(uint32_t key) {
+    ShaderPermutation permutation;
+    permutation.normalMethod = static_cast<int>(key % NORMAL_METHOD_COUNT);
+    key /= NORMAL_METHOD_COUNT;
+    permutation.selectionHighlight = (key % 2) != 0;
+    key /= 2;
+    permutation.lighting = (key % 2) != 0;
+    key /= 2;
+    permutation.debugMode = static_cast<int>(key);
+    return permutation;
+}
+
+std::string ShaderPermutation::getDefines() const {
+    ShaderPermutation clamped = fromKey(getKey());
+    std::ostringstream defines;
+    defines << "#define ASTRAL_DEBUG_MODE " << clamped.debugMode << "\n"
+            << "#define ASTRAL_LIGHTING " << (clamped.lighting ? 1 : 0) << "\n"
+            << "#define ASTRAL_SELECTION_HIGHLIGHT " << (clamped.selectionHighlight ? 1 : 0) << "\n"
+            << "#define ASTRAL_NORMAL_METHOD " << clamped.normalMethod << "\n";
+    return defines.str();
+}
+
+void ShaderPermutationCache::init(ShaderCache* cache, std::string vertexSource, std::string fragmentSource) {
+    m_cache = cache;
+    m_vertexSource = std::move(vertexSource);
+    m_fragmentSource = std::move(fragmentSource);
+}
+
+void ShaderPermutationCache::destroy() {
+    for (Entry& entry : m_entries) {
+        if (entry.pending.isActive() && m_cache) m_cache->cancelProgram(entry.pending);
+        if (entry.program) glDeleteProgram(entry.program);
+        entry = Entry{};
+    }
+}
+
+void ShaderPermutationCache::begin(uint32_t key) {
+    Entry& entry = m_entries[key];
+    if (!m_cache || entry.program || entry.pending.isActive() || entry.failed) return;
+    entry.pending = m_cache->beginProgram(m_vertexSource, m_fragmentSource, ShaderPermutation::fromKey(key).getDefines());
+}
+
+GLuint ShaderPermutationCache::get(const ShaderPermutation& permutation) {
+    const uint32_t key = permutation.getKey();
+    begin(key);
+    return m_entries[key].program;
+}
+
+void ShaderPermutationCache::prewarmAll() {
+    for (uint32_t key = 0; key < ShaderPermutation::COUNT; ++key) begin(key);
+}
+
+bool ShaderPermutationCache::poll() {
+    if (!m_cache) return false;
+    bool becameReady = false;
+    for (uint32_t key = 0; key < ShaderPermutation::COUNT; ++key) {
+        Entry& entry = m_entries[key];
+        if (!entry.pending.isActive() || !m_cache->isProgramReady(entry.pending)) continue;
+
+        entry.program = m_cache->finishProgram(entry.pending);
+        if (entry.program) {
+            becameReady = true;
+        } else {
+            cerr << "ERROR::SHADER_PERMUTATION::BUILD_FAILED\n" << ShaderPermutation::fromKey(key).getDefines() << endl;
+            entry.failed = true;
+        }
+        if (!m_cache->isParallelCompileSupported()) break;
+    }
+    return becameReady;
+}
+
+int ShaderPermutationCache::getReadyCount() const {
+    int count = 0;
+    for (const Entry& entry : m_entries) count += (entry.program != 0) ? 1 : 0;
+    return count;
+}
+
+int ShaderPermutationCache::getPendingCount() const {
+    int count = 0;
+    for (const Entry& entry : m_entries) count += entry.pending.isActive() ? 1 : 0;
+    return count;
+}
@@ -0,0 +1,62 @@
+//
+// Variants of raymarch.frag with the per-pixel mode switches fixed by #defines (the ASTRAL_* block in the shader).
+// Built in the background through ShaderCache, either the first time a variant is asked for or all at once (prewarm);
+// until then the caller draws with the uber shader, which reads the same modes from the FrameBlock.
+//
+#pragma once
+#include <glad/glad.h>
+#include <cstdint>
+#include <string>
+#include "utilities/ShaderCache.h"
+
+struct ShaderPermutation {
+    static constexpr int DEBUG_MODE_COUNT = 5;      // u_debugMode values, see the switch in main() of the shader
+    static constexpr int NORMAL_METHOD_COUNT = 2;   // NormalMethod in AstralUI.h
+    static constexpr int COUNT = DEBUG_MODE_COUNT * 2 * 2 * NORMAL_METHOD_COUNT;
+
+    int debugMode = 0;
+    bool lighting = true;
+    bool selectionHighlight = true;
+    int normalMethod = 0;
+
+    // Dense index in [0, COUNT), out of range modes are clamped
+    uint32_t getKey() const;
+    static ShaderPermutation fromKey(uint32_t key);
+
+    // "#define ASTRAL_DEBUG_MODE 0\n..." for ShaderCache / injectDefines
+    std::string getDefines() const;
+};
+
+class ShaderPermutationCache {
+public:
+    // cache must outlive this object
+    void init(ShaderCache* cache, std::string vertexSource, std::string fragmentSource);
+    void destroy();
+
+    // Ready program for the permutation, or 0 while it builds (the first request starts the build) or if it failed
+    GLuint get(const ShaderPermutation& permutation);
+
+    // Starts building every variant that is neither built nor building
+    void prewarmAll();
+
+    // Takes over the builds the driver has finished, call once per frame. Returns true if a variant became ready.
+    // Without parallel compile every finish blocks, so only one is taken per frame
+    bool poll();
+
+    int getReadyCount() const;
+    int getPendingCount() const;
+
+private:
+    struct Entry {
+        GLuint program = 0;
+        PendingProgram pending;
+        bool failed = false;
+    };
+
+    void begin(uint32_t key);
+
+    ShaderCache* m_cache = nullptr;
+    std::string m_vertexSource;
+    std::string m_fragmentSource;
+    Entry m_entries[ShaderPermutation::COUNT];
+};
@@ -0,0 +1,104 @@
+//
+// Work-stealing thread pool
+//
+
+#include "ThreadPool.h"
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned threadCount) {
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (unsigned i = 0; i < threadCount; ++i) {
+        m_queues.push_back(std::make_unique<WorkQueue>());
+    }
+    for (unsigned i = 0; i < threadCount; ++i) {
+        m_threads.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_stateMutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for (auto& thread : m_threads) {
+        thread.join();
+    }
+}
+
+void ThreadPool::parallelFor(int count, const std::function<void(int)>& job) {
+    if (count <= 0) return;
+
+    m_job = &job;
+    m_remaining.store(count);
+
+    // Deal contiguous blocks so neighbouring tasks (tiles) start on the same worker
+    const unsigned workers = getThreadCount();
+    const int blockSize = (count + static_cast<int>(workers) - 1) / static_cast<int>(workers);
+    for (unsigned w = 0; w < workers; ++w) {
+        std::lock_guard<std::mutex> lock(m_queues[w]->mutex);
+        int begin = static_cast<int>(w) * blockSize;
+        int end = std::min(count, begin + blockSize);
+        for (int i = begin; i < end; ++i) {
+            m_queues[w]->tasks.push_back(i);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_stateMutex);
+        ++m_generation;
+    }
+    m_wake.notify_all();
+
+    std::unique_lock<std::mutex> lock(m_stateMutex);
+    m_done.wait(lock, [this] { return m_remaining.load() == 0; });
+    m_job = nullptr;
+}
+
+bool ThreadPool::popOrSteal(unsigned self, int& task) {
+    // Own queue first, from the back (most recently dealt, still warm)
+    {
+        WorkQueue& own = *m_queues[self];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = own.tasks.back();
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+    // Steal from the front of the other queues
+    const unsigned workers = getThreadCount();
+    for (unsigned offset = 1; offset < workers; ++offset) {
+        WorkQueue& victim = *m_queues[(self + offset) % workers];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = victim.tasks.front();
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::workerLoop(unsigned self) {
+    unsigned long long seenGeneration = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(m_stateMutex);
+            m_wake.wait(lock, [&] { return m_stop || m_generation != seenGeneration; });
+            if (m_stop) return;
+            seenGeneration = m_generation;
+        }
+
+        int task;
+        while (popOrSteal(self, task)) {
+            (*m_job)(task);
+            if (m_remaining.fetch_sub(1) == 1) {
+                std::lock_guard<std::mutex> lock(m_stateMutex);
+                m_done.notify_all();
+            }
+        }
+    }
+}
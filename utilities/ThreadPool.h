@@ -0,0 +1,49 @@
+//
+// Small work-stealing thread pool used by the CPU renderer
+//
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool {
+public:
+    // threadCount 0 uses every hardware thread
+    explicit ThreadPool(unsigned threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Runs job(i) for every i in [0, count) and blocks until all of them finished.
+    // Tasks are dealt out in contiguous blocks, idle workers steal from the others.
+    void parallelFor(int count, const std::function<void(int)>& job);
+
+    unsigned getThreadCount() const { return static_cast<unsigned>(m_threads.size()); }
+
+private:
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<int> tasks;
+    };
+
+    void workerLoop(unsigned self);
+    bool popOrSteal(unsigned self, int& task);
+
+    std::vector<std::thread> m_threads;
+    std::vector<std::unique_ptr<WorkQueue>> m_queues;
+
+    const std::function<void(int)>* m_job = nullptr;
+    std::atomic<int> m_remaining{0};
+
+    std::mutex m_stateMutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    unsigned long long m_generation = 0;
+    bool m_stop = false;
+};
@@ -6,6 +6,9 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <thread>
 #include "glm/fwd.hpp"
 #include "glm/vec3.hpp"
 #include "Basic/Camera.h"
@@ -44,3 +47,52 @@ size_t utility::getCurrentRSS() {
     return 0;
 
 }
+
+void utility::preciseSleepUntil(std::chrono::steady_clock::time_point deadline) {
+    using namespace std::chrono;
+    // OS sleeps overshoot by up to a scheduler tick, so stop sleeping ~2 ms early
+    const auto spinMargin = milliseconds(2);
+    for (auto now = steady_clock::now(); now < deadline; now = steady_clock::now()) {
+        if (deadline - now > spinMargin) {
+            std::this_thread::sleep_for(milliseconds(1));
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+bool utility::writePPM(const std::string &filePath, int width, int height, const std::vector<vec3> &pixels) {
+    std::ofstream file(filePath, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "ERROR::IMAGE::FILE_NOT_SUCCESSFULLY_WRITTEN " << filePath << std::endl;
+        return false;
+    }
+    file << "P6\n" << width << " " << height << "\n255\n";
+
+    // PPM is stored top row first, same rounding as an RGBA8 render target
+    std::vector<unsigned char> row(static_cast<size_t>(width) * 3);
+    for (int y = height - 1; y >= 0; --y) {
+        for (int x = 0; x < width; ++x) {
+            const vec3& c = pixels[static_cast<size_t>(y) * width + x];
+            for (int channel = 0; channel < 3; ++channel) {
+                float v = std::clamp(c[channel], 0.0f, 1.0f);
+                row[x * 3 + channel] = static_cast<unsigned char>(std::lround(v * 255.0f));
+            }
+        }
+        file.write(reinterpret_cast<const char*>(row.data()), static_cast<std::streamsize>(row.size()));
+    }
+    return file.good();
+}
+
+bool utility::writePFM(const std::string &filePath, int width, int height, const std::vector<vec3> &pixels) {
+    std::ofstream file(filePath, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "ERROR::IMAGE::FILE_NOT_SUCCESSFULLY_WRITTEN " << filePath << std::endl;
+        return false;
+    }
+    // Negative scale = little endian; PFM rows already go bottom to top
+    file << "PF\n" << width << " " << height << "\n-1.0\n";
+    file.write(reinterpret_cast<const char*>(pixels.data()),
+               static_cast<std::streamsize>(static_cast<size_t>(width) * height * sizeof(vec3)));
+    return file.good();
+}
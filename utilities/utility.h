@@ -2,6 +2,7 @@
 // Created by bysta on 10/04/2025.
 //
 #pragma once
+#include <chrono>
 #include <string>
 #include <vector>
 #include <glm/gtc/type_ptr.hpp>
@@ -13,6 +14,13 @@ class Camera;
 namespace utility {
     std::string loadShaderSource(const std::string& filePath);
     size_t getCurrentRSS(); // Platform-specific RAM usage
+
+    // Sleeps until the deadline: coarse sleeps first, then yields for the last stretch the OS timer can't hit
+    void preciseSleepUntil(std::chrono::steady_clock::time_point deadline);
+
+    // Image output, pixels are given bottom row first (glReadPixels order)
+    bool writePPM(const std::string& filePath, int width, int height, const std::vector<glm::vec3>& pixels); // 8-bit binary
+    bool writePFM(const std::string& filePath, int width, int height, const std::vector<glm::vec3>& pixels); // 32-bit float
 }
 
 